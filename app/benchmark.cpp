@@ -0,0 +1,537 @@
+#include <iostream>
+#include <chrono>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include "MFCC.hpp"
+#include "StaticMFCC.hpp"
+#include "GMM.hpp"
+#include "CMVN.hpp"
+#include "DataHandler.hpp"
+
+#define NUM_WORDS   16
+
+// private typedefs
+typedef std::chrono::high_resolution_clock Clock;
+typedef std::chrono::milliseconds Milliseconds;
+
+/**
+ * @brief Result of one pipeline on the recog/ set
+ *
+ */
+struct PipelineResult
+{
+    int correct = 0;
+    long long trainMs = 0;
+    long long recogMs = 0;
+    long long scoreMs = 0;                          // part of recogMs in the GMM
+    int components = 0;                             // components evaluated per frame and model
+    int codewords = 0;                              // codeword distances per frame
+    std::vector<std::string> names;                 // recognized word per utterance
+    std::vector<std::vector<double>> likelihood;    // log-likelihood per utterance and model
+    std::vector<std::vector<double>> features;      // features of all utterances
+};
+
+/**
+ * @brief Reads a 16000 Hz file and converts it to inputRate, in place of capture hardware at that rate
+ *
+ * @param filePath  (string)
+ * @param inputRate (int)    Sample rate of the returned signal
+ * @param sizeData  (size_t) Maximum number of samples at 16000 Hz
+ * @return          (vector) Empty if the file can not be read
+ */
+std::vector<short int> ReadSignal(const std::string& filePath, int inputRate, size_t sizeData)
+{
+    DataHandler datahandler;
+    Resampler capture(16000, inputRate);
+    std::vector<short int> voiceBuffer(sizeData), signal;
+    size_t realSize;
+
+    realSize = datahandler.ReadWav(filePath, voiceBuffer.data(), sizeData, 0);
+    if(realSize < 1 || realSize > sizeData) return signal;
+
+    // Group delay of the filter dropped and its tail flushed, the capture stays aligned with the file
+    signal.resize(capture.GetOutputSize(realSize) + capture.GetDelay());
+    realSize = capture.Process(voiceBuffer.data(), realSize, signal.data());
+    realSize += capture.Flush(&signal[realSize]);
+    signal.resize(realSize);
+    signal.erase(signal.begin(), signal.begin() + std::min(realSize, capture.GetDelay()));
+    return signal;
+}
+
+/**
+ * @brief Trains the models on train/ and recognizes recog/ with features, models and scoring in T
+ *
+ * @param root      (string) Directory with the train/ and recog/ folders
+ * @param fastMath  (bool)   Polynomial exp/log of FastMath instead of libm
+ * @param inputRate (int)    Rate of the signals, converted to 16000 Hz by the MFCC
+ * @param mixtures  (int)    Components per model
+ * @param codewords (int)    Codebook of the Gaussian selection, 0 to evaluate all components
+ * @param shortlist (int)    Components evaluated per frame and model with the selection
+ * @return          (PipelineResult)
+ */
+template<typename T>
+PipelineResult RunPipeline(const std::string& root, bool fastMath, int inputRate = 16000, int mixtures = 12, int codewords = 0, int shortlist = 0)
+{
+    DataHandler datahandler;
+    BasicMFCC<T> mfcc(16000, 25, 10, BasicMFCC<T>::Hamming, 40, 12);
+    BasicGMM<T> gmm(mixtures, 12);
+    PipelineResult result;
+    std::vector<short int> voiceBuffer;
+    size_t frameCount, realSize;
+    Clock::time_point start, scoreStart;
+
+    mfcc.setFastMath(fastMath);
+    mfcc.setInputRate(inputRate);
+    gmm.setFastMath(fastMath);
+
+    ///*** Trainning, the models stay in memory
+    start = Clock::now();
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        for(int num = 1; num <= 3; num++)
+        {
+            voiceBuffer = ReadSignal(root + datahandler.GetFilePath(wordId, num, 0, "wav"), inputRate, TRAINSIZE);
+            realSize = voiceBuffer.size();
+            if(realSize < 1) continue;
+
+            frameCount = mfcc.Analyse(voiceBuffer.data(), realSize);
+            gmm.Expectation_Maximation(mfcc.GetMFCCData(), frameCount);
+            gmm.AddModel(datahandler.GetWord(wordId));
+        }
+    }
+    if(codewords > 0 && gmm.BuildGaussianSelection(codewords, shortlist))
+        result.codewords = codewords;
+    result.components = gmm.GetSelectedComponents();
+    result.trainMs = std::chrono::duration_cast<Milliseconds>(Clock::now() - start).count();
+
+    ///*** Recognition
+    start = Clock::now();
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        voiceBuffer = ReadSignal(root + datahandler.GetFilePath(wordId, 0, 1, "wav"), inputRate, RECOGSIZE);
+        realSize = voiceBuffer.size();
+        if(realSize < 1) continue;
+
+        frameCount = mfcc.Analyse(voiceBuffer.data(), realSize);
+        const BasicFeatureMatrix<T>& melCepData = mfcc.GetMFCCData();
+
+        scoreStart = Clock::now();
+        gmm.StartClassify();
+        gmm.AddFrames(melCepData.View(0, frameCount));
+        std::string name = gmm.GetBest();
+        result.scoreMs += std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - scoreStart).count();
+
+        // Likelihoods in the order of the model names
+        std::vector<std::pair<std::string, double>> nBest = gmm.GetNBest(NUM_WORDS + 1);
+        std::sort(nBest.begin(), nBest.end());
+        std::vector<double> likelihood;
+        for(size_t i = 0; i < nBest.size(); i++)
+            likelihood.push_back(nBest[i].second);
+
+        std::vector<double> features;
+        for(size_t i = 0; i < frameCount; i++)
+            features.insert(features.end(), melCepData[i], melCepData[i] + melCepData.GetCols());
+
+        if(name == datahandler.GetWord(wordId)) result.correct++;
+        result.names.push_back(name);
+        result.likelihood.push_back(likelihood);
+        result.features.push_back(features);
+    }
+    result.recogMs = std::chrono::duration_cast<Milliseconds>(Clock::now() - start).count();
+    result.scoreMs /= 1000;
+
+    return result;
+}
+
+/**
+ * @brief Time of the MFCC analyse of all train/ and recog/ signals at inputRate
+ *
+ * @param root      (string) Directory with the train/ and recog/ folders
+ * @param frequence (int)    Rate of the front end, inputRate runs it without conversion
+ * @param inputRate (int)    Rate of the signals
+ * @return          (long long) Milliseconds
+ */
+long long FrontEndMs(const std::string& root, int frequence, int inputRate)
+{
+    DataHandler datahandler;
+    MFCC mfcc(frequence, 25, 10, MFCC::Hamming, 40, 12);
+    std::vector<std::vector<short int>> signals;
+    Clock::time_point start;
+
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        for(int num = 0; num <= 3; num++)
+        {
+            signals.push_back(ReadSignal(root + datahandler.GetFilePath(wordId, num, num == 0 ? 1 : 0, "wav"), inputRate, TRAINSIZE));
+            if(signals.back().empty()) signals.pop_back();
+        }
+    }
+
+    mfcc.setInputRate(inputRate);
+    start = Clock::now();
+    for(size_t i = 0; i < signals.size(); i++)
+        mfcc.Analyse(signals[i].data(), signals[i].size());
+
+    return std::chrono::duration_cast<Milliseconds>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Front end of all train/ and recog/ signals with a new analyser per signal,
+ *        the runtime MFCC against StaticMFCC of the same configuration
+ *
+ * @param root (string) Directory with the train/ and recog/ folders
+ */
+void CompareStaticFrontEnd(const std::string& root)
+{
+    typedef StaticMFCC<16000, 25, 10, 40, 12, MFCC::Hamming> Static;
+    DataHandler datahandler;
+    std::vector<std::vector<short int>> signals;
+    std::chrono::duration<double, std::milli> runtimeSetup(0), runtimeAnalyse(0), staticSetup(0), staticAnalyse(0);
+    Clock::time_point start, built;
+    double difference = 0;
+
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        for(int num = 0; num <= 3; num++)
+        {
+            signals.push_back(ReadSignal(root + datahandler.GetFilePath(wordId, num, num == 0 ? 1 : 0, "wav"), 16000, TRAINSIZE));
+            if(signals.back().empty()) signals.pop_back();
+        }
+    }
+
+    for(size_t i = 0; i < signals.size(); i++)
+    {
+        start = Clock::now();
+        MFCC mfcc(16000, 25, 10, MFCC::Hamming, 40, 12);
+        built = Clock::now();
+        mfcc.Analyse(signals[i].data(), signals[i].size());
+        runtimeAnalyse += Clock::now() - built;
+        runtimeSetup += built - start;
+
+        start = Clock::now();
+        Static fixed;
+        built = Clock::now();
+        fixed.Analyse(signals[i].data(), signals[i].size());
+        staticAnalyse += Clock::now() - built;
+        staticSetup += built - start;
+
+        FeatureView a = mfcc.GetFeatures(), b = fixed.GetFeatures();
+        for(size_t r = 0; r < a.rows; r++)
+            for(size_t c = 0; c < a.cols; c++)
+                difference = std::max(difference, fabs(a[r][c] - b[r][c]));
+    }
+
+    std::cout << "runtime MFCC: setup " << runtimeSetup.count() << " ms, analyse " << runtimeAnalyse.count() << " ms" << std::endl;
+    std::cout << "StaticMFCC  : setup " << staticSetup.count() << " ms, analyse " << staticAnalyse.count() << " ms" << std::endl;
+    std::cout << "largest feature difference: " << difference << std::endl;
+}
+
+/**
+ * @brief Classify of all recog/ utterances with beam pruning against the full search
+ *
+ * @param root  (string) Directory with the train/ and recog/ folders
+ * @param beams (vector) Beams to compare, log-likelihood below the leader
+ */
+void CompareBeam(const std::string& root, const std::vector<double>& beams)
+{
+    DataHandler datahandler;
+    MFCC mfcc(16000, 25, 10, MFCC::Hamming, 40, 12);
+    GMM gmm;
+    std::vector<FeatureMatrix> utterances;
+    std::vector<std::string> reference;
+    std::vector<short int> voiceBuffer;
+    size_t frameCount;
+
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        for(int num = 1; num <= 3; num++)
+        {
+            voiceBuffer = ReadSignal(root + datahandler.GetFilePath(wordId, num, 0, "wav"), 16000, TRAINSIZE);
+            if(voiceBuffer.empty()) continue;
+
+            frameCount = mfcc.Analyse(voiceBuffer.data(), voiceBuffer.size());
+            gmm.Expectation_Maximation(mfcc.GetMFCCData(), frameCount);
+            gmm.AddModel(datahandler.GetWord(wordId));
+        }
+
+        voiceBuffer = ReadSignal(root + datahandler.GetFilePath(wordId, 0, 1, "wav"), 16000, RECOGSIZE);
+        if(voiceBuffer.empty()) continue;
+
+        frameCount = mfcc.Analyse(voiceBuffer.data(), voiceBuffer.size());
+        utterances.push_back(mfcc.GetMFCCData());
+        utterances.back().Resize(frameCount, utterances.back().GetCols());
+    }
+
+    for(size_t b = 0; b <= beams.size(); b++)
+    {
+        std::chrono::duration<double, std::milli> elapsed(0);
+        size_t pruned = 0;
+        int decisions = 0;
+
+        // The first pass is the full search, the reference of the others
+        gmm.setBeam(b == 0 ? 0 : beams[b - 1]);
+        for(size_t u = 0; u < utterances.size(); u++)
+        {
+            Clock::time_point start = Clock::now();
+            std::string name = gmm.Classify(utterances[u], utterances[u].GetRows());
+            elapsed += Clock::now() - start;
+
+            if(b == 0) reference.push_back(name);
+            if(name != reference[u]) decisions++;
+            pruned += gmm.GetPrunedCount();
+        }
+
+        std::cout << (b == 0 ? std::string("full search") : "beam " + std::to_string((int)beams[b - 1])) << ": " << elapsed.count() << " ms, ";
+        std::cout << "pruned " << (double)pruned / utterances.size() << " of " << gmm.GetModelCount() << " models, changed decisions " << decisions << " of " << utterances.size() << std::endl;
+    }
+}
+
+/**
+ * @brief EM trainning of one model on all train/ and recog/ signals pooled into one recording,
+ *        on the calling thread and on a thread pool
+ *
+ * @param root    (string) Directory with the train/ and recog/ folders
+ * @param workers (int)    Threads of the pool
+ */
+void CompareTraining(const std::string& root, int workers)
+{
+    DataHandler datahandler;
+    MFCC mfcc(16000, 25, 10, MFCC::Hamming, 40, 12);
+    ThreadPool pool(workers);
+    std::vector<short int> pooled, voiceBuffer;
+    double likelihood[2];
+    size_t frameCount;
+
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        for(int num = 0; num <= 3; num++)
+        {
+            voiceBuffer = ReadSignal(root + datahandler.GetFilePath(wordId, num, num == 0 ? 1 : 0, "wav"), 16000, TRAINSIZE);
+            pooled.insert(pooled.end(), voiceBuffer.begin(), voiceBuffer.end());
+        }
+    }
+    frameCount = mfcc.Analyse(pooled.data(), pooled.size());
+
+    for(int p = 0; p < 2; p++)
+    {
+        GMM gmm;
+        Clock::time_point start = Clock::now();
+
+        if(p == 1) gmm.setThreadPool(&pool);
+        int loop = gmm.Expectation_Maximation(mfcc.GetMFCCData(), frameCount);
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+        likelihood[p] = gmm.Likelihood(mfcc.GetMFCCData(), frameCount);
+
+        std::cout << (p == 0 ? "single thread" : std::to_string(workers) + " workers  ") << ": " << frameCount << " frames, " << loop << " loops, " << elapsed.count() << " ms" << std::endl;
+    }
+    std::cout << "same model: " << (likelihood[0] == likelihood[1] ? "yes" : "no") << std::endl;
+}
+
+/**
+ * @brief Trainning and recognition on the raw features, normalized with the mean and variance
+ *        of each utterance and with the global statistics of the trainning data (CMVN)
+ *
+ * @param root (string) Directory with the train/ and recog/ folders
+ */
+void CompareNormalization(const std::string& root)
+{
+    const std::string names[] = {"raw features  ", "utterance CMVN", "global CMVN   "};
+    DataHandler datahandler;
+    MFCC mfcc(16000, 25, 10, MFCC::Hamming, 40, 12);
+    std::vector<FeatureMatrix> train, recog;
+    std::vector<std::string> trainWords, recogWords;
+    std::vector<short int> voiceBuffer;
+    size_t frameCount;
+
+    for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
+    {
+        for(int num = 0; num <= 3; num++)
+        {
+            voiceBuffer = ReadSignal(root + datahandler.GetFilePath(wordId, num, num == 0 ? 1 : 0, "wav"), 16000, num == 0 ? RECOGSIZE : TRAINSIZE);
+            if(voiceBuffer.empty()) continue;
+
+            frameCount = mfcc.Analyse(voiceBuffer.data(), voiceBuffer.size());
+            std::vector<FeatureMatrix>& set = num == 0 ? recog : train;
+            set.push_back(mfcc.GetMFCCData());
+            set.back().Resize(frameCount, set.back().GetCols());
+            (num == 0 ? recogWords : trainWords).push_back(datahandler.GetWord(wordId));
+        }
+    }
+
+    for(int mode = 0; mode < 3; mode++)
+    {
+        GMM gmm;
+        CMVN cmvn(mfcc.GetFeatureDim());
+        std::vector<FeatureMatrix> trainSet = train, recogSet = recog;
+        int converged = 0, correct = 0;
+
+        for(size_t i = 0; i < trainSet.size() && mode == 2; i++)
+            cmvn.Accumulate(trainSet[i], trainSet[i].GetRows());
+        for(size_t i = 0; i < trainSet.size() + recogSet.size() && mode > 0; i++)
+        {
+            FeatureMatrix& features = i < trainSet.size() ? trainSet[i] : recogSet[i - trainSet.size()];
+            if(mode == 1)
+                cmvn.Normalize(features, features.GetRows());
+            else
+                cmvn.Apply(features, features.GetRows());
+        }
+
+        Clock::time_point start = Clock::now();
+        for(size_t i = 0; i < trainSet.size(); i++)
+        {
+            gmm.Expectation_Maximation(trainSet[i], trainSet[i].GetRows());
+            converged += gmm.GetConvergedIteration();
+            gmm.AddModel(trainWords[i]);
+        }
+        std::chrono::duration<double, std::milli> elapsed = Clock::now() - start;
+
+        for(size_t u = 0; u < recogSet.size(); u++)
+        {
+            if(gmm.Classify(recogSet[u], recogSet[u].GetRows()) == recogWords[u]) correct++;
+        }
+
+        std::cout << names[mode] << ": WA " << correct * 100.0 / recogSet.size() << "%, EM converged after ";
+        std::cout << (double)converged / trainSet.size() << " loops per model, training " << elapsed.count() << " ms" << std::endl;
+    }
+}
+
+/**
+ * @brief Largest differences of a pipeline to the reference pipeline
+ *
+ */
+struct PipelineDelta
+{
+    int decisions = 0;
+    double feature = 0;
+    double likelihood = 0;
+    double relative = 0;
+};
+
+/**
+ * @brief Compares the features, log-likelihoods and decisions of two pipelines
+ *
+ * @param ref   (PipelineResult) Reference
+ * @param other (PipelineResult)
+ * @return      (PipelineDelta)
+ */
+PipelineDelta Compare(const PipelineResult& ref, const PipelineResult& other)
+{
+    PipelineDelta delta;
+
+    for(size_t u = 0; u < ref.names.size() && u < other.names.size(); u++)
+    {
+        if(ref.names[u] != other.names[u]) delta.decisions++;
+
+        for(size_t i = 0; i < ref.features[u].size() && i < other.features[u].size(); i++)
+            delta.feature = std::max(delta.feature, fabs(ref.features[u][i] - other.features[u][i]));
+
+        for(size_t m = 0; m < ref.likelihood[u].size() && m < other.likelihood[u].size(); m++)
+        {
+            double diff = fabs(ref.likelihood[u][m] - other.likelihood[u][m]);
+            delta.likelihood = std::max(delta.likelihood, diff);
+            delta.relative = std::max(delta.relative, diff / fabs(ref.likelihood[u][m]));
+        }
+    }
+
+    return delta;
+}
+
+/**
+ * @brief Prints the accuracy and time of a pipeline and its differences to the reference
+ *
+ * @param name  (string)         Label of the pipeline
+ * @param ref   (PipelineResult) Reference
+ * @param other (PipelineResult)
+ * @return      (PipelineDelta)
+ */
+PipelineDelta Report(const std::string& name, const PipelineResult& ref, const PipelineResult& other)
+{
+    PipelineDelta delta = Compare(ref, other);
+
+    std::cout << name << ": WA " << other.correct * 100.0 / (NUM_WORDS + 1) << "%, training " << other.trainMs << " ms, recognition " << other.recogMs << " ms" << std::endl;
+    std::cout << "    accuracy delta     : " << (other.correct - ref.correct) * 100.0 / (NUM_WORDS + 1) << "%" << std::endl;
+    std::cout << "    changed decisions  : " << delta.decisions << " of " << ref.names.size() << std::endl;
+    std::cout << "    max feature delta  : " << delta.feature << std::endl;
+    std::cout << "    max log-lik. delta : " << delta.likelihood << " (relative " << delta.relative << ")" << std::endl;
+
+    return delta;
+}
+
+/**
+ * @brief Recognition with the Gaussian selection against all components of models of the same size
+ *
+ * @param root       (string) Directory with the train/ and recog/ folders
+ * @param mixtures   (int)    Components per model
+ * @param codewords  (int)    Codebook of the selection
+ * @param shortlists (vector) Components evaluated per frame and model
+ */
+void CompareSelection(const std::string& root, int mixtures, int codewords, const std::vector<int>& shortlists)
+{
+    PipelineResult ref = RunPipeline<double>(root, false, 16000, mixtures);
+
+    std::cout << mixtures << " mixtures: WA " << ref.correct * 100.0 / (NUM_WORDS + 1) << "%, scoring " << ref.scoreMs << " ms" << std::endl;
+    for(size_t i = 0; i < shortlists.size(); i++)
+    {
+        std::ostringstream name;
+        name << "    " << codewords << " codewords, shortlist " << shortlists[i];
+        PipelineResult selected = RunPipeline<double>(root, false, 16000, mixtures, codewords, shortlists[i]);
+        Report(name.str(), ref, selected);
+        std::cout << "    components/frame   : " << selected.components << " of " << ref.components << " per model (";
+        std::cout << (double)ref.components / selected.components << "x fewer), plus " << selected.codewords << " codeword distances" << std::endl;
+        std::cout << "    scoring            : " << selected.scoreMs << " ms (" << ref.scoreMs << " ms without selection)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string root = argc > 1 ? argv[1] : "./";
+    if(root.back() != '/') root += '/';
+
+    PipelineResult ref = RunPipeline<double>(root, false);
+    PipelineResult single = RunPipeline<float>(root, false);
+    PipelineResult fastRef = RunPipeline<double>(root, true);
+    PipelineResult fastSingle = RunPipeline<float>(root, true);
+
+    std::cout << std::endl << std::endl << "*** FLOAT32 vs DOUBLE on recog/ ***" << std::endl;
+    std::cout << "double: WA " << ref.correct * 100.0 / (NUM_WORDS + 1) << "%, training " << ref.trainMs << " ms, recognition " << ref.recogMs << " ms" << std::endl;
+    Report("float ", ref, single);
+
+    ///*** The drift of the fast exp/log has to stay far below the float32 rounding
+    std::cout << std::endl << "*** FASTMATH vs LIBM on recog/ ***" << std::endl;
+    PipelineDelta fastDouble = Report("double", ref, fastRef);
+    PipelineDelta fastFloat = Report("float ", single, fastSingle);
+
+    ///*** 48 kHz capture: the whole front end at 48 kHz, or converted to the 16 kHz front end
+    std::cout << std::endl << "*** 48 kHz INPUT ***" << std::endl;
+    std::cout << "front end 16 kHz input            : " << FrontEndMs(root, 16000, 16000) << " ms" << std::endl;
+    std::cout << "front end 48 kHz                  : " << FrontEndMs(root, 48000, 48000) << " ms" << std::endl;
+    std::cout << "front end 48 kHz resampled to 16k : " << FrontEndMs(root, 16000, 48000) << " ms" << std::endl;
+    Report("resampled", ref, RunPipeline<double>(root, false, 48000));
+
+    ///*** One configuration fixed at compile time, a new analyser per utterance
+    std::cout << std::endl << "*** STATIC MFCC vs RUNTIME MFCC ***" << std::endl;
+    CompareStaticFrontEnd(root);
+
+    ///*** Models dropped after blocks of 200 ms when they fall behind the leader by the beam
+    std::cout << std::endl << "*** BEAM PRUNING ***" << std::endl;
+    CompareBeam(root, {2000, 1000, 500, 200});
+
+    ///*** Statistics of the E step per shard of frames, reduced in a fixed order
+    std::cout << std::endl << "*** EM TRAINING ***" << std::endl;
+    CompareTraining(root, 4);
+
+    ///*** Cepstral mean and variance normalization, per utterance or with the statistics of train/
+    std::cout << std::endl << "*** FEATURE NORMALIZATION ***" << std::endl;
+    CompareNormalization(root);
+
+    ///*** Shortlist of the components per frame and model, the gain grows with the mixtures
+    std::cout << std::endl << "*** GAUSSIAN SELECTION ***" << std::endl;
+    CompareSelection(root, 12, 64, {2, 4, 6});
+    CompareSelection(root, 32, 64, {4, 6, 8});
+
+    bool passed = fastDouble.decisions == 0 && fastDouble.relative < 1e-10 && fastFloat.relative < 1e-4;
+    std::cout << "drift bound (double 1e-10, float 1e-4 relative, no changed decision in double): " << (passed ? "passed" : "FAILED") << std::endl;
+
+    return passed ? 0 : 1;
+}
@@ -13,11 +13,6 @@
 typedef std::chrono::high_resolution_clock Clock;
 typedef std::chrono::milliseconds Milliseconds;
 
-// Private variables
-const double MFCC::PI  = 3.14159265358979323846;
-const double MFCC::PI2 = 2*PI;
-const double MFCC::PI4 = 4*PI;
-
 // Private prototypes
 std::string GetWord(std::string name);
 
@@ -29,17 +24,20 @@ int main()
     Milliseconds ms;
     DataHandler datahandler;
     GMM gmm;
+    ThreadPool pool;
 
     // Declare variables
 	std::string filePath, name;
     short int bigVoiceBuffer[TRAINSIZE], littleVoiceBuffer[2000];
 	size_t frameCount, realSize;
-    std::vector<std::vector<double> > melCepData;
     int replacements = 0, omissions= 0, insertions = 0, wrong_word = 0, loop;
     std::map<std::string, int> recognizer;
 
-    // Initialize MFCC
+    // Initialize MFCC, unchanged files are loaded from the feature cache
+    FeatureCache cache("/Users/timkrebs/OneDrive/Uni/8.Semester/Bachelorarbeit/02_Programme/C++/ASR_GMM/cache");
     MFCC mfcc(16000, 25, 10, MFCC::Hamming, 40, 12);
+    mfcc.setInputRate(FREQ);
+    mfcc.setFeatureCache(&cache);
 
     /***************************************************************************
      * TRAINNING *
@@ -47,11 +45,13 @@ int main()
     std::cout << "*** TRAINNING ***" << std::endl;
     trainStart = Clock::now();
 
+    //** Load wav files
+    std::vector<std::vector<short int>> trainData;
+    std::vector<std::pair<int, int>> trainFiles;
     for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
     {
         for(int num = 1; num <= 3; num++)
         {
-            //** Load wav file
             std::string path = "/Users/timkrebs/OneDrive/Uni/8.Semester/Bachelorarbeit/02_Programme/C++/ASR_GMM/";
             filePath = datahandler.GetFilePath(wordId, num, 0, "wav");
             filePath = path.append(filePath);
@@ -60,30 +60,34 @@ int main()
             // Check if read operation was successfull
             if(realSize < 1) continue;
 
-
-            //** Mfcc analyse WITH BIG BUFFER
-            frameCount = mfcc.Analyse(bigVoiceBuffer,realSize);
-            melCepData = mfcc.GetMFCCData();
-
+            trainData.push_back(std::vector<short int>(bigVoiceBuffer, bigVoiceBuffer + realSize));
+            trainFiles.push_back(std::make_pair(wordId, num));
             filePath.erase();
-            path = "/Users/timkrebs/OneDrive/Uni/8.Semester/Bachelorarbeit/02_Programme/C++/ASR_GMM/";
+        }
+    }
 
-            //** GMM trainning
-            loop = gmm.Expectation_Maximation(melCepData, frameCount);
-            filePath = datahandler.GetFilePath(wordId, num, 2, "gmm");
+    //** Mfcc analyse of all files on the worker threads, long files are also trained on them
+    std::vector<FeatureMatrix> trainFeatures = mfcc.AnalyseBatch(trainData, pool);
+    gmm.setThreadPool(&pool);
 
-            filePath = path.append(filePath);
+    for(size_t i = 0; i < trainFiles.size(); i++)
+    {
+        std::string path = "/Users/timkrebs/OneDrive/Uni/8.Semester/Bachelorarbeit/02_Programme/C++/ASR_GMM/";
 
-            gmm.SaveModel(filePath);
+        //** GMM trainning
+        loop = gmm.Expectation_Maximation(trainFeatures[i], trainFeatures[i].GetRows());
+        filePath = datahandler.GetFilePath(trainFiles[i].first, trainFiles[i].second, 2, "gmm");
 
-            std::cout << " : " << loop << " trainning loops" << std::endl;
-            filePath.erase();
-        }
+        filePath = path.append(filePath);
 
+        gmm.SaveModel(filePath);
+
+        std::cout << " : " << loop << " trainning loops" << std::endl;
+        filePath.erase();
     }
     trainEnd = Clock::now();
 
-    //** Reload saved models for Recognition task
+    //** Reload saved models for Recognition task, they are scored on the workers
     for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
     {
         for(int num=1; num<=3; num++)
@@ -116,7 +120,7 @@ int main()
         if(realSize < 1) continue;
 
         frameCount = mfcc.Analyse(bigVoiceBuffer,realSize);
-        melCepData = mfcc.GetMFCCData();
+        const FeatureMatrix& melCepData = mfcc.GetMFCCData();
 
         // Returns Modelname with the best probability
         name = gmm.Classify(melCepData, frameCount);
@@ -144,6 +148,9 @@ int main()
     std::cout << std::endl << "*** RECOGNITION best percentage ***" << std::endl;
     recogPercentStart = Clock::now();
 
+    // Only the new frames of each buffer are scored
+    mfcc.setFrameCallback([&gmm](const FeatureView& frames, size_t) { gmm.AddFrames(frames); });
+
     for(int wordId = 0; wordId <= NUM_WORDS; wordId++)
     {
         std::string path = "/Users/timkrebs/OneDrive/Uni/8.Semester/Bachelorarbeit/02_Programme/C++/ASR_GMM/";
@@ -152,6 +159,7 @@ int main()
         bool bcontinue = true;
         size_t position = 0;
         mfcc.StartAnalyse(RECOGSIZE);
+        gmm.StartClassify();
         filePath = datahandler.GetFilePath(wordId, 0, 1, "wav");
         filePath = path.append(filePath);
 
@@ -164,7 +172,7 @@ int main()
             if(realSize != 2000) bcontinue = false;
             if(position > 8000)
             {
-                name = gmm.Classify(mfcc.GetMFCCData(), mfcc.GetFrameCount());
+                name = gmm.GetBest();
                 recognizer[name]++;
             }
         } while(bcontinue);
@@ -201,6 +209,7 @@ int main()
 
         filePath.erase();
     }
+    mfcc.setFrameCallback(nullptr);
     recogPercentEnd = Clock::now();
     std::cout << std::endl;
 
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <fstream>
+#include <math.h>
+
+#include "FeatureMatrix.hpp"
+
+/**
+ * @brief Cepstral mean (and variance) normalization of feature frames
+ *        Utterance: Normalize uses the statistics of the utterance itself.
+ *        Global:    Accumulate collects statistics over the trainning data, Apply uses them,
+ *                   GMM::setCMVN writes them into every model file of the set (Write/Read),
+ *                   Save/Load keep them in a file of their own.
+ *        Stream:    StartStream/Process normalize with the last window frames, the running
+ *                   sums are updated in O(dims) per frame, e.g. in the MFCC frame callback.
+ *                   Global statistics fill the window at the start of the stream.
+ *        The sums are kept in double, T is the type of the features.
+ *
+ */
+template<typename T>
+class BasicCMVN
+{
+public:
+    enum Mode
+    {
+        Mean,
+        MeanVariance
+    };
+
+private:
+    /* data */
+    void normalizeFrame(const T* input, T* output, const double sum[], const double sumSquare[], double count);
+
+    int m_Dim;
+    Mode m_Mode;
+
+    //Global statistics
+    std::vector<double> m_Sum;
+    std::vector<double> m_SumSquare;
+    double m_Count;
+
+    //Stream, the frames of the window in a ring
+    size_t m_Window;
+    size_t m_StreamFrames;
+    std::vector<double> m_WindowSum;
+    std::vector<double> m_WindowSumSquare;
+    std::vector<double> m_PriorSum;
+    std::vector<double> m_PriorSumSquare;
+    BasicFeatureMatrix<T> m_History;
+    BasicFeatureMatrix<T> m_Output;
+
+    // Smallest variance, silent dimensions are not blown up
+    static constexpr double MinVariance = 1e-6;
+
+public:
+    BasicCMVN(int dim, Mode mode = MeanVariance);
+    virtual ~BasicCMVN();
+
+    void Normalize(BasicFeatureMatrix<T>& features, size_t frameCount);
+    void Accumulate(const BasicFeatureView<T>& features, size_t frameCount);
+    void Apply(BasicFeatureMatrix<T>& features, size_t frameCount);
+    void ResetStatistics();
+    size_t GetFrameCount();
+    std::vector<double> GetMean();
+    std::vector<double> GetVariance();
+    bool Save(const std::string& filePath);
+    bool Load(const std::string& filePath);
+    void Write(std::ostream& outFile);
+    bool Read(std::istream& inFile);
+    bool Matches(BasicCMVN<T>& other, double tolerance = 1e-9);
+
+    void StartStream(size_t window);
+    BasicFeatureView<T> Process(const BasicFeatureView<T>& frames);
+};
+
+/**
+ * @brief Construct a new BasicCMVN object
+ *
+ * @param dim  (int)  Number of features per frame, MFCC::GetFeatureDim
+ * @param mode (enum) Mean: mean only, MeanVariance: mean and variance
+ */
+template<typename T>
+BasicCMVN<T>::BasicCMVN(int dim, Mode mode) : m_Dim(dim), m_Mode(mode)
+{
+    m_Window = 0;
+    m_StreamFrames = 0;
+
+    ResetStatistics();
+}
+
+template<typename T>
+BasicCMVN<T>::~BasicCMVN()
+{
+    m_Sum.clear();
+    m_SumSquare.clear();
+    m_WindowSum.clear();
+    m_WindowSumSquare.clear();
+    m_PriorSum.clear();
+    m_PriorSumSquare.clear();
+}
+
+/**
+ * @brief Normalizes an utterance with its own mean (and variance)
+ *
+ * @param features   (FeatureMatrix) Frames, normalized in place
+ * @param frameCount (size_t)        Number of frames
+ */
+template<typename T>
+void BasicCMVN<T>::Normalize(BasicFeatureMatrix<T>& features, size_t frameCount)
+{
+    std::vector<double> sum(m_Dim, 0.0), sumSquare(m_Dim, 0.0);
+
+    if(frameCount == 0) return;
+
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        for(int j = 0; j < m_Dim; j++)
+        {
+            sum[j] += features[i][j];
+            sumSquare[j] += (double)features[i][j] * features[i][j];
+        }
+    }
+
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        normalizeFrame(features[i], features[i], sum.data(), sumSquare.data(), (double)frameCount);
+    }
+}
+
+/**
+ * @brief Adds the frames to the global statistics
+ *
+ * @param features   (FeatureView) Frames
+ * @param frameCount (size_t)      Number of frames
+ */
+template<typename T>
+void BasicCMVN<T>::Accumulate(const BasicFeatureView<T>& features, size_t frameCount)
+{
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        for(int j = 0; j < m_Dim; j++)
+        {
+            m_Sum[j] += features[i][j];
+            m_SumSquare[j] += (double)features[i][j] * features[i][j];
+        }
+    }
+    m_Count += frameCount;
+}
+
+/**
+ * @brief Normalizes an utterance with the global statistics (Accumulate or Load)
+ *
+ * @param features   (FeatureMatrix) Frames, normalized in place
+ * @param frameCount (size_t)        Number of frames
+ */
+template<typename T>
+void BasicCMVN<T>::Apply(BasicFeatureMatrix<T>& features, size_t frameCount)
+{
+    if(m_Count == 0) return;
+
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        normalizeFrame(features[i], features[i], m_Sum.data(), m_SumSquare.data(), m_Count);
+    }
+}
+
+/**
+ * @brief Clears the global statistics
+ *
+ */
+template<typename T>
+void BasicCMVN<T>::ResetStatistics()
+{
+    m_Sum.assign(m_Dim, 0.0);
+    m_SumSquare.assign(m_Dim, 0.0);
+    m_Count = 0;
+}
+
+/**
+ * @brief Returns the number of frames in the global statistics
+ *
+ * @return (size_t)
+ */
+template<typename T>
+size_t BasicCMVN<T>::GetFrameCount()
+{
+    return (size_t)m_Count;
+}
+
+/**
+ * @brief Returns the global mean
+ *
+ * @return (vector) Dim values, zeros without statistics
+ */
+template<typename T>
+std::vector<double> BasicCMVN<T>::GetMean()
+{
+    std::vector<double> mean(m_Dim, 0.0);
+
+    for(int j = 0; j < m_Dim && m_Count > 0; j++)
+        mean[j] = m_Sum[j] / m_Count;
+
+    return mean;
+}
+
+/**
+ * @brief Returns the global variance
+ *
+ * @return (vector) Dim values, ones without statistics
+ */
+template<typename T>
+std::vector<double> BasicCMVN<T>::GetVariance()
+{
+    std::vector<double> variance(m_Dim, 1.0);
+    double mean;
+
+    for(int j = 0; j < m_Dim && m_Count > 0; j++)
+    {
+        mean = m_Sum[j] / m_Count;
+        variance[j] = std::max(m_SumSquare[j] / m_Count - mean * mean, MinVariance);
+    }
+
+    return variance;
+}
+
+/**
+ * @brief Saves the global statistics to a text file of their own
+ *
+ * @param filePath (string) Path of the file
+ * @return         (bool) If operation was successful
+ */
+template<typename T>
+bool BasicCMVN<T>::Save(const std::string& filePath)
+{
+    std::ofstream outFile(filePath);
+
+    if(!outFile.is_open())
+        return false;
+
+    Write(outFile);
+    outFile.close();
+    return true;
+}
+
+/**
+ * @brief Loads the global statistics saved by Save
+ *
+ * @param filePath (string) Path of the file
+ * @return         (bool) If operation was successful
+ */
+template<typename T>
+bool BasicCMVN<T>::Load(const std::string& filePath)
+{
+    std::ifstream inFile(filePath, std::ifstream::in);
+    if(!inFile.is_open())
+        return false;
+
+    return Read(inFile);
+}
+
+/**
+ * @brief Writes the global statistics as text, in a file of their own or in a model file
+ *
+ * @param outFile (ostream)
+ */
+template<typename T>
+void BasicCMVN<T>::Write(std::ostream& outFile)
+{
+    std::vector<double> mean = GetMean(), variance = GetVariance();
+
+    outFile << std::defaultfloat << std::setprecision(17);
+    outFile << "frames:" << std::endl << m_Count << std::endl;
+
+    outFile << "mean:" << std::endl;
+    for(int j = 0; j < m_Dim; j++)
+        outFile << mean[j] << " ";
+
+    outFile << std::endl << "variance:" << std::endl;
+    for(int j = 0; j < m_Dim; j++)
+        outFile << variance[j] << " ";
+    outFile << std::endl;
+}
+
+/**
+ * @brief Reads the global statistics written by Write, they replace the current ones
+ *
+ * @param inFile (istream)
+ * @return       (bool) If operation was successful, the statistics are unchanged otherwise
+ */
+template<typename T>
+bool BasicCMVN<T>::Read(std::istream& inFile)
+{
+    std::string title;
+    std::vector<double> mean(m_Dim), variance(m_Dim);
+    double count;
+
+    inFile >> title >> count;
+    inFile >> title;
+    for(int j = 0; j < m_Dim; j++)
+        inFile >> mean[j];
+    inFile >> title;
+    for(int j = 0; j < m_Dim; j++)
+        inFile >> variance[j];
+
+    if(!inFile || count <= 0)
+        return false;
+
+    // Back to sums, so Accumulate can go on with more data
+    m_Count = count;
+    for(int j = 0; j < m_Dim; j++)
+    {
+        m_Sum[j] = mean[j] * count;
+        m_SumSquare[j] = (variance[j] + mean[j] * mean[j]) * count;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns true if both have the same global statistics, e.g. the models of one set
+ *
+ * @param other     (CMVN)
+ * @param tolerance (double) Largest relative difference of the mean and variance
+ * @return          (bool)
+ */
+template<typename T>
+bool BasicCMVN<T>::Matches(BasicCMVN<T>& other, double tolerance)
+{
+    std::vector<double> mean = GetMean(), variance = GetVariance();
+    std::vector<double> otherMean = other.GetMean(), otherVariance = other.GetVariance();
+
+    if(m_Dim != other.m_Dim || GetFrameCount() != other.GetFrameCount())
+        return false;
+
+    for(int j = 0; j < m_Dim; j++)
+    {
+        if(fabs(mean[j] - otherMean[j]) > tolerance * std::max(fabs(mean[j]), 1.0))
+            return false;
+        if(fabs(variance[j] - otherVariance[j]) > tolerance * variance[j])
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Starts the normalization of a stream over a sliding window
+ *        Until window frames are seen, the rest of the window is filled with the global
+ *        statistics, without them only the frames of the stream are used.
+ *        The buffers are allocated here, Process does not allocate memory
+ *        for chunks of up to window frames.
+ *
+ * @param window (size_t) Number of frames of the window, e.g. 300 (3 s)
+ */
+template<typename T>
+void BasicCMVN<T>::StartStream(size_t window)
+{
+    m_Window = std::max(window, (size_t)1);
+    m_StreamFrames = 0;
+    m_WindowSum.assign(m_Dim, 0.0);
+    m_WindowSumSquare.assign(m_Dim, 0.0);
+    m_PriorSum.assign(m_Dim, 0.0);
+    m_PriorSumSquare.assign(m_Dim, 0.0);
+    m_History.Resize(m_Window, m_Dim);
+    m_Output.Resize(m_Window, m_Dim);
+}
+
+/**
+ * @brief Normalizes the next frames of the stream with the statistics of the last window frames
+ *        (the frame itself included). The speech tags of frames are passed on.
+ *
+ * @param frames (FeatureView) New frames, e.g. from the MFCC frame callback
+ * @return       (FeatureView) Normalized frames, valid until the next call
+ */
+template<typename T>
+BasicFeatureView<T> BasicCMVN<T>::Process(const BasicFeatureView<T>& frames)
+{
+    BasicFeatureView<T> output;
+    double prior;
+    T* slot;
+
+    if(m_Window == 0) StartStream(300);
+    if(m_Output.GetRows() < frames.rows)
+        m_Output.Resize(frames.rows, m_Dim);
+
+    for(size_t i = 0; i < frames.rows; i++)
+    {
+        const T* frame = frames[i];
+        slot = m_History[m_StreamFrames % m_Window];
+
+        // The oldest frame leaves the window
+        if(m_StreamFrames >= m_Window)
+        {
+            for(int j = 0; j < m_Dim; j++)
+            {
+                m_WindowSum[j] -= slot[j];
+                m_WindowSumSquare[j] -= (double)slot[j] * slot[j];
+            }
+        }
+
+        for(int j = 0; j < m_Dim; j++)
+        {
+            slot[j] = frame[j];
+            m_WindowSum[j] += frame[j];
+            m_WindowSumSquare[j] += (double)frame[j] * frame[j];
+        }
+        m_StreamFrames++;
+
+        // The sums are computed again once per window, rounding errors do not pile up
+        if(m_StreamFrames % m_Window == 0)
+        {
+            m_WindowSum.assign(m_Dim, 0.0);
+            m_WindowSumSquare.assign(m_Dim, 0.0);
+            for(size_t k = 0; k < m_Window; k++)
+            {
+                for(int j = 0; j < m_Dim; j++)
+                {
+                    m_WindowSum[j] += m_History[k][j];
+                    m_WindowSumSquare[j] += (double)m_History[k][j] * m_History[k][j];
+                }
+            }
+        }
+
+        if(m_StreamFrames >= m_Window || m_Count == 0)
+        {
+            normalizeFrame(frame, m_Output[i], m_WindowSum.data(), m_WindowSumSquare.data(), (double)std::min(m_StreamFrames, m_Window));
+            continue;
+        }
+
+        // Start of the stream, the free part of the window holds the global statistics
+        prior = (double)(m_Window - m_StreamFrames) / m_Count;
+        for(int j = 0; j < m_Dim; j++)
+        {
+            m_PriorSum[j] = m_WindowSum[j] + m_Sum[j] * prior;
+            m_PriorSumSquare[j] = m_WindowSumSquare[j] + m_SumSquare[j] * prior;
+        }
+        normalizeFrame(frame, m_Output[i], m_PriorSum.data(), m_PriorSumSquare.data(), (double)m_Window);
+    }
+
+    output = m_Output.View(0, frames.rows);
+    output.speech = frames.speech;
+
+    return output;
+}
+
+/**
+ * @brief output = (input - mean) / sqrt(variance), or input - mean
+ *
+ * @param input     (T)      Frame (Dim)
+ * @param output    (T)      Normalized frame (Dim), may be input
+ * @param sum       (double) Sum of the frames (Dim)
+ * @param sumSquare (double) Sum of the squared frames (Dim)
+ * @param count     (double) Number of frames in the sums
+ */
+template<typename T>
+void BasicCMVN<T>::normalizeFrame(const T* input, T* output, const double sum[], const double sumSquare[], double count)
+{
+    double mean, variance;
+
+    for(int j = 0; j < m_Dim; j++)
+    {
+        mean = sum[j] / count;
+
+        if(m_Mode == MeanVariance)
+        {
+            variance = std::max(sumSquare[j] / count - mean * mean, MinVariance);
+            output[j] = (T)((input[j] - mean) / sqrt(variance));
+        }
+        else
+            output[j] = (T)(input[j] - mean);
+    }
+}
+
+typedef BasicCMVN<double> CMVN;
+typedef BasicCMVN<float> CMVNF;
@@ -9,7 +9,7 @@
 #include <map>
 
 #define SECONDS 3
-#define FREQ    16000              //You can try 48000 to use 48000Hz wav files, but it's more slow.
+#define FREQ    16000              //You can try 48000 to use 48000Hz wav files, MFCC::setInputRate(FREQ) converts them to 16000Hz.
 #define TRAINSIZE FREQ * SECONDS        //4 secondes of voice for trainning
                                 // --- you can increase this value to improve the recognition rate
 #define RECOGSIZE FREQ * SECONDS        //1 seconde of voice for recognition
@@ -0,0 +1,596 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#include "Simd.hpp"
+
+class FFT
+{
+private:
+    /* data */
+    void pack(const double data[]);
+    void pack(const double data[], size_t dataStride, size_t frameCount);
+    template <typename V> void transform(V* data, V* scratch);
+    template <typename V> void split(const V* data, int k, V& xr, V& xi);
+    template <typename V> void butterfly(V* data, int radix, int m, const double* twiddle, const double* roots, V* scratch);
+
+    static std::vector<int> factorize(int size);
+
+    //Settings
+    int m_Size;
+    int m_HalfSize;
+
+    //Plan
+    std::vector<int> m_Radix;
+    std::vector<int> m_Permutation;
+    std::vector<int> m_StageOffset;
+    std::vector<int> m_RootOffset;
+    std::vector<double> m_Twiddle;
+    std::vector<double> m_Roots;
+    std::vector<double> m_PostTwiddle;
+    std::vector<double> m_Buffer;
+    std::vector<double> m_Scratch;
+    std::vector<SimdDouble> m_BatchBuffer;
+    std::vector<SimdDouble> m_BatchScratch;
+
+    static constexpr double PI2 = 6.28318530717958647692;
+
+public:
+    FFT();
+    FFT(int size);
+    virtual ~FFT();
+
+    void Forward(const double data[], double spectrum[]);
+    void PowerSpectrum(const double data[], double power[]);
+    void PowerSpectrum(const double data[], size_t dataStride, double power[], size_t powerStride, size_t frameCount);
+    int GetSize();
+    int GetBinCount();
+
+    static constexpr int NextPowerOfTwo(int size);
+    static bool IsSmooth(int size);
+    static constexpr double EstimateCost(int size);
+
+    static constexpr int BatchSize = SimdDouble::Lanes;
+};
+
+/**
+ * @brief Construct an empty FFT::FFT plan
+ *
+ */
+FFT::FFT() : FFT(2)
+{
+}
+
+/**
+ * @brief Construct a new FFT::FFT plan for real input
+ *        The N real samples are packed into N/2 complex points, which are
+ *        transformed by mixed-radix (4, 2, 3, 5, generic) butterfly stages.
+ *        The digit-reversal and twiddle tables are computed once here and the
+ *        per-frame transform does not call any trigonometric function.
+ *
+ * @param size (int) Length N of the real input, must be even
+ */
+FFT::FFT(int size)
+{
+    int weight, rem, stride, index, radix, m;
+    int maxRadix = 1;
+
+    m_Size = size;
+    m_HalfSize = size / 2;
+    m_Radix = factorize(m_HalfSize);
+
+    ///*** Digit-reversal table of the N/2 complex transform
+    m_Permutation.resize(m_HalfSize);
+    for(int pos = 0; pos < m_HalfSize; pos++)
+    {
+        rem = pos;
+        weight = m_HalfSize;
+        stride = 1;
+        index = 0;
+        for(int s = (int)m_Radix.size() - 1; s >= 0; s--)
+        {
+            weight /= m_Radix[s];
+            index += (rem / weight) * stride;
+            rem %= weight;
+            stride *= m_Radix[s];
+        }
+        m_Permutation[pos] = index;
+    }
+
+    ///*** Twiddles of each stage: exp(-i*2*PI*r*k/L), L = radix*m
+    m = 1;
+    for(size_t s = 0; s < m_Radix.size(); s++)
+    {
+        radix = m_Radix[s];
+        m_StageOffset.push_back((int)m_Twiddle.size());
+        for(int k = 0; k < m; k++)
+        {
+            for(int r = 1; r < radix; r++)
+            {
+                m_Twiddle.push_back(cos(PI2 * r * k / (radix * m)));
+                m_Twiddle.push_back(-sin(PI2 * r * k / (radix * m)));
+            }
+        }
+
+        // Roots of unity of the generic kernel
+        m_RootOffset.push_back((int)m_Roots.size());
+        if(radix > 5)
+        {
+            for(int r = 0; r < radix; r++)
+            {
+                m_Roots.push_back(cos(PI2 * r / radix));
+                m_Roots.push_back(-sin(PI2 * r / radix));
+            }
+        }
+
+        if(radix > maxRadix) maxRadix = radix;
+        m *= radix;
+    }
+    m_Roots.push_back(0.0);
+
+    ///*** Post-twiddles splitting the packed spectrum: exp(-i*2*PI*k/N)
+    for(int k = 0; k <= m_HalfSize; k++)
+    {
+        m_PostTwiddle.push_back(cos(PI2 * k / m_Size));
+        m_PostTwiddle.push_back(-sin(PI2 * k / m_Size));
+    }
+
+    m_Buffer.resize(2 * m_HalfSize);
+    m_Scratch.resize(2 * maxRadix);
+    m_BatchBuffer.resize(2 * m_HalfSize);
+    m_BatchScratch.resize(2 * maxRadix);
+}
+
+/**
+ * @brief Destroy the FFT::FFT plan
+ *
+ */
+FFT::~FFT()
+{
+    m_Radix.clear();
+    m_Permutation.clear();
+    m_StageOffset.clear();
+    m_RootOffset.clear();
+    m_Twiddle.clear();
+    m_Roots.clear();
+    m_PostTwiddle.clear();
+    m_Buffer.clear();
+    m_Scratch.clear();
+    m_BatchBuffer.clear();
+    m_BatchScratch.clear();
+}
+
+/**
+ * @brief Computes the spectrum of a real frame
+ *
+ * @param data      (double) N real samples
+ * @param spectrum  (double) N/2+1 complex bins, interleaved (re, im)
+ */
+void FFT::Forward(const double data[], double spectrum[])
+{
+    pack(data);
+    transform(m_Buffer.data(), m_Scratch.data());
+
+    for(int k = 0; k <= m_HalfSize; k++)
+    {
+        split(m_Buffer.data(), k, spectrum[k << 1], spectrum[(k << 1) + 1]);
+    }
+}
+
+/**
+ * @brief Computes the power spectrum |X(k)|^2 of a real frame
+ *
+ * @param data  (double) N real samples
+ * @param power (double) N/2+1 power bins
+ */
+void FFT::PowerSpectrum(const double data[], double power[])
+{
+    double xr, xi;
+
+    pack(data);
+    transform(m_Buffer.data(), m_Scratch.data());
+
+    for(int k = 0; k <= m_HalfSize; k++)
+    {
+        split(m_Buffer.data(), k, xr, xi);
+        power[k] = xr * xr + xi * xi;
+    }
+}
+
+/**
+ * @brief Computes the power spectra of a block of frames
+ *        BatchSize frames run through the same butterflies at once, one frame
+ *        per SIMD lane, so every frame gets exactly the result of the one-frame
+ *        PowerSpectrum.
+ *
+ * @param data        (double) Frames of N real samples
+ * @param dataStride  (size_t) Distance between two frames in data
+ * @param power       (double) Power spectra of N/2+1 bins
+ * @param powerStride (size_t) Distance between two spectra in power
+ * @param frameCount  (size_t) Number of frames
+ */
+void FFT::PowerSpectrum(const double data[], size_t dataStride, double power[], size_t powerStride, size_t frameCount)
+{
+    alignas(64) double lanes[BatchSize];
+    SimdDouble xr, xi;
+    size_t count;
+
+    for(size_t i = 0; i < frameCount; i += BatchSize)
+    {
+        count = std::min(frameCount - i, (size_t)BatchSize);
+
+        pack(&data[i * dataStride], dataStride, count);
+        transform(m_BatchBuffer.data(), m_BatchScratch.data());
+
+        for(int k = 0; k <= m_HalfSize; k++)
+        {
+            split(m_BatchBuffer.data(), k, xr, xi);
+            (xr * xr + xi * xi).Store(lanes);
+            for(size_t l = 0; l < count; l++)
+            {
+                power[(i + l) * powerStride + k] = lanes[l];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the length N of the real input
+ *
+ * @return (int)
+ */
+int FFT::GetSize()
+{
+    return m_Size;
+}
+
+/**
+ * @brief Returns the number of spectral bins N/2+1
+ *
+ * @return (int)
+ */
+int FFT::GetBinCount()
+{
+    return m_HalfSize + 1;
+}
+
+/**
+ * @brief Smallest power of 2 which is not lower than size
+ *
+ * @param size (int)
+ * @return     (int)
+ */
+constexpr int FFT::NextPowerOfTwo(int size)
+{
+    int n = 2;
+
+    while(n < size)
+        n <<= 1;
+
+    return n;
+}
+
+/**
+ * @brief Checks if a real transform of this size only needs 2, 3 and 5 kernels
+ *
+ * @param size (int) Length N of the real input
+ * @return     (bool)
+ */
+bool FFT::IsSmooth(int size)
+{
+    if(size < 2 || size % 2 != 0) return false;
+
+    std::vector<int> radix = factorize(size / 2);
+    for(size_t s = 0; s < radix.size(); s++)
+    {
+        if(radix[s] > 5) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Rough number of real operations of a transform, used to choose
+ *        between a mixed-radix plan and a zero padded power of 2 plan
+ *        The radices are found in the order of factorize, constexpr for StaticMFCC.
+ *
+ * @param size (int) Length N of the real input
+ * @return     (double)
+ */
+constexpr double FFT::EstimateCost(int size)
+{
+    int rest = size / 2;
+    double cost = 0.0;
+
+    while(rest % 4 == 0)
+    {
+        cost += 8.5;
+        rest /= 4;
+    }
+
+    for(int p = 2; rest > 1; p++)
+    {
+        while(rest % p == 0)
+        {
+            switch(p)
+            {
+                case 2 : cost += 5.0; break;
+                case 3 : cost += 8.0; break;
+                case 5 : cost += 10.4; break;
+                default: cost += 4.0 * p + 6.0; break;
+            }
+            rest /= p;
+        }
+    }
+
+    // Butterflies on N/2 points plus the split of the N/2+1 bins
+    return (size / 2) * cost + 10.0 * (size / 2 + 1);
+}
+
+/**
+ * @brief Splits the transform length into radices, 4 first, then 2, 3, 5
+ *        and the remaining primes
+ *
+ * @param size (int) Length of the complex transform
+ * @return     (vector) Radix of each butterfly stage
+ */
+std::vector<int> FFT::factorize(int size)
+{
+    std::vector<int> radix;
+
+    while(size % 4 == 0)
+    {
+        radix.push_back(4);
+        size /= 4;
+    }
+
+    for(int p = 2; size > 1; p++)
+    {
+        while(size % p == 0)
+        {
+            radix.push_back(p);
+            size /= p;
+        }
+    }
+
+    return radix;
+}
+
+/**
+ * @brief Packs the even/odd samples as real/imaginary parts of the
+ *        N/2 complex points in digit-reversed order
+ *
+ * @param data (double) N real samples
+ */
+void FFT::pack(const double data[])
+{
+    int c;
+
+    for(int i = 0; i < m_HalfSize; i++)
+    {
+        c = m_Permutation[i];
+        m_Buffer[i << 1] = data[c << 1];
+        m_Buffer[(i << 1) + 1] = data[(c << 1) + 1];
+    }
+}
+
+/**
+ * @brief Packs up to BatchSize frames lane by lane, the unused lanes are zero
+ *
+ * @param data       (double) Frames of N real samples
+ * @param dataStride (size_t) Distance between two frames in data
+ * @param frameCount (size_t) Number of frames, at most BatchSize
+ */
+void FFT::pack(const double data[], size_t dataStride, size_t frameCount)
+{
+    alignas(64) double re[BatchSize], im[BatchSize];
+    int c;
+
+    for(int l = (int)frameCount; l < BatchSize; l++)
+    {
+        re[l] = 0.0;
+        im[l] = 0.0;
+    }
+
+    for(int i = 0; i < m_HalfSize; i++)
+    {
+        c = m_Permutation[i];
+        for(size_t l = 0; l < frameCount; l++)
+        {
+            re[l] = data[l * dataStride + (c << 1)];
+            im[l] = data[l * dataStride + (c << 1) + 1];
+        }
+        m_BatchBuffer[i << 1] = SimdDouble::Load(re);
+        m_BatchBuffer[(i << 1) + 1] = SimdDouble::Load(im);
+    }
+}
+
+/**
+ * @brief Splits the packed spectrum Z into the bin X(k) of the real signal
+ *        X(k) = (Z(k) + Z*(N/2-k))/2 - i*W^k*(Z(k) - Z*(N/2-k))/2
+ *
+ * @param data (V)   Packed spectrum Z, interleaved (re, im)
+ * @param k    (int) Bin index, 0 <= k <= N/2
+ * @param xr   (V)   Real part of X(k)
+ * @param xi   (V)   Imaginary part of X(k)
+ */
+template <typename V>
+void FFT::split(const V* data, int k, V& xr, V& xi)
+{
+    int a = k % m_HalfSize;
+    int c = (m_HalfSize - k) % m_HalfSize;
+    V zr = data[a << 1];
+    V zi = data[(a << 1) + 1];
+    V cr = data[c << 1];
+    V ci = data[(c << 1) + 1];
+    double wr = m_PostTwiddle[k << 1];
+    double wi = m_PostTwiddle[(k << 1) + 1];
+
+    V er = 0.5 * (zr + cr);
+    V ei = 0.5 * (zi - ci);
+    V or_ = 0.5 * (zi + ci);
+    V oi = -0.5 * (zr - cr);
+
+    xr = er + wr * or_ - wi * oi;
+    xi = ei + wr * oi + wi * or_;
+}
+
+/**
+ * @brief In-place decimation in time stages of the N/2 complex transform,
+ *        the input must already be in digit-reversed order
+ *
+ * @param data    (V) N/2 complex points, interleaved (re, im)
+ * @param scratch (V) Work space of the generic kernel
+ */
+template <typename V>
+void FFT::transform(V* data, V* scratch)
+{
+    int m = 1;
+
+    for(size_t s = 0; s < m_Radix.size(); s++)
+    {
+        int radix = m_Radix[s];
+        int len = radix * m;
+
+        for(int i = 0; i < m_HalfSize; i += len)
+        {
+            butterfly(&data[i << 1], radix, m, &m_Twiddle[m_StageOffset[s]], &m_Roots[m_RootOffset[s]], scratch);
+        }
+        m = len;
+    }
+}
+
+/**
+ * @brief Combines radix sub-transforms of length m into one of length radix*m
+ *
+ * @param data    (V)      radix*m complex points, interleaved (re, im)
+ * @param radix   (int)    Radix of the stage
+ * @param m       (int)    Length of the sub-transforms
+ * @param twiddle (double) Stage twiddles exp(-i*2*PI*r*k/(radix*m))
+ * @param roots   (double) Roots of unity exp(-i*2*PI*r/radix), generic kernel only
+ * @param scratch (V)      Work space of the generic kernel, 2*radix points
+ */
+template <typename V>
+void FFT::butterfly(V* data, int radix, int m, const double* twiddle, const double* roots, V* scratch)
+{
+    static const double C3 = -0.5;
+    static const double S3 = 0.86602540378443864676;
+    static const double C51 = 0.30901699437494742410;
+    static const double C52 = -0.80901699437494742410;
+    static const double S51 = 0.95105651629515357212;
+    static const double S52 = 0.58778525229247312917;
+
+    V ar[5], ai[5];
+    V* x[5];
+    const double* w;
+
+    for(int k = 0; k < m; k++)
+    {
+        w = &twiddle[2 * (radix - 1) * k];
+
+        if(radix > 5)
+        {
+            ///*** Generic kernel, O(radix^2)
+            V* t = scratch;
+
+            t[0] = data[k << 1];
+            t[1] = data[(k << 1) + 1];
+            for(int r = 1; r < radix; r++)
+            {
+                V* p = &data[(r * m + k) << 1];
+                t[2 * r] = w[2 * (r - 1)] * p[0] - w[2 * (r - 1) + 1] * p[1];
+                t[2 * r + 1] = w[2 * (r - 1)] * p[1] + w[2 * (r - 1) + 1] * p[0];
+            }
+            for(int q = 0; q < radix; q++)
+            {
+                V yr = t[0];
+                V yi = t[1];
+                for(int r = 1; r < radix; r++)
+                {
+                    int e = (r * q) % radix;
+                    yr = yr + (roots[2 * e] * t[2 * r] - roots[2 * e + 1] * t[2 * r + 1]);
+                    yi = yi + (roots[2 * e] * t[2 * r + 1] + roots[2 * e + 1] * t[2 * r]);
+                }
+                data[(q * m + k) << 1] = yr;
+                data[((q * m + k) << 1) + 1] = yi;
+            }
+            continue;
+        }
+
+        ///*** Apply the twiddles
+        x[0] = &data[k << 1];
+        ar[0] = x[0][0];
+        ai[0] = x[0][1];
+        for(int r = 1; r < radix; r++)
+        {
+            x[r] = &data[(r * m + k) << 1];
+            ar[r] = w[2 * (r - 1)] * x[r][0] - w[2 * (r - 1) + 1] * x[r][1];
+            ai[r] = w[2 * (r - 1)] * x[r][1] + w[2 * (r - 1) + 1] * x[r][0];
+        }
+
+        switch(radix)
+        {
+            case 2 :
+                x[0][0] = ar[0] + ar[1];
+                x[0][1] = ai[0] + ai[1];
+                x[1][0] = ar[0] - ar[1];
+                x[1][1] = ai[0] - ai[1];
+                break;
+
+            case 3 :
+            {
+                V tr = ar[1] + ar[2], ti = ai[1] + ai[2];
+                V mr = ar[0] + C3 * tr, mi = ai[0] + C3 * ti;
+                V dr = S3 * (ar[1] - ar[2]), di = S3 * (ai[1] - ai[2]);
+                x[0][0] = ar[0] + tr;
+                x[0][1] = ai[0] + ti;
+                x[1][0] = mr + di;
+                x[1][1] = mi - dr;
+                x[2][0] = mr - di;
+                x[2][1] = mi + dr;
+                break;
+            }
+
+            case 4 :
+            {
+                V t0r = ar[0] + ar[2], t0i = ai[0] + ai[2];
+                V t1r = ar[0] - ar[2], t1i = ai[0] - ai[2];
+                V t2r = ar[1] + ar[3], t2i = ai[1] + ai[3];
+                V t3r = ar[1] - ar[3], t3i = ai[1] - ai[3];
+                x[0][0] = t0r + t2r;
+                x[0][1] = t0i + t2i;
+                x[1][0] = t1r + t3i;
+                x[1][1] = t1i - t3r;
+                x[2][0] = t0r - t2r;
+                x[2][1] = t0i - t2i;
+                x[3][0] = t1r - t3i;
+                x[3][1] = t1i + t3r;
+                break;
+            }
+
+            case 5 :
+            {
+                V b1r = ar[1] + ar[4], b1i = ai[1] + ai[4];
+                V b2r = ar[2] + ar[3], b2i = ai[2] + ai[3];
+                V d1r = ar[1] - ar[4], d1i = ai[1] - ai[4];
+                V d2r = ar[2] - ar[3], d2i = ai[2] - ai[3];
+                V m1r = ar[0] + C51 * b1r + C52 * b2r, m1i = ai[0] + C51 * b1i + C52 * b2i;
+                V m2r = ar[0] + C52 * b1r + C51 * b2r, m2i = ai[0] + C52 * b1i + C51 * b2i;
+                V n1r = S51 * d1r + S52 * d2r, n1i = S51 * d1i + S52 * d2i;
+                V n2r = S52 * d1r - S51 * d2r, n2i = S52 * d1i - S51 * d2i;
+                x[0][0] = ar[0] + b1r + b2r;
+                x[0][1] = ai[0] + b1i + b2i;
+                x[1][0] = m1r + n1i;
+                x[1][1] = m1i - n1r;
+                x[4][0] = m1r - n1i;
+                x[4][1] = m1i + n1r;
+                x[2][0] = m2r + n2i;
+                x[2][1] = m2i - n2r;
+                x[3][0] = m2r - n2i;
+                x[3][1] = m2i + n2r;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,518 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <math.h>
+
+#include "Simd.hpp"
+
+/**
+ * @brief Polynomial exp and log for the hot loops of MFCC, GMM and HMM
+ *        The array versions run on SimdDouble/SimdFloat, the scalar functions take the remainder.
+ *        They only pay off with AVX2/AVX-512 (USE_NATIVE_ARCH): the SSE2 fallback of Simd.hpp
+ *        computes the lanes one by one and is slower than the table-driven exp and log of glibc.
+ *        Error bounds against libm, measured on 2e7 random inputs:
+ *          Exp(double): relative error < 1e-14    input clamped to [-708, 708]
+ *          Exp(float) : relative error < 3e-7     input clamped to [-87, 88]
+ *          Log(double): error < 2e-14 * max(1, |log x|)    for normal x > 0, -inf for 0, NaN below
+ *          Log(float) : error < 2e-7 * max(1, |log x|)
+ *        MFCC, GMM and HMM use them after setFastMath(true), the default is on with USE_FAST_MATH,
+ *        which should go together with USE_NATIVE_ARCH.
+ *
+ */
+class FastMath
+{
+private:
+    static constexpr double Log2E = 1.44269504088896340736;
+    static constexpr double Ln2Hi = 6.93147180369123816490e-01;
+    static constexpr double Ln2Lo = 1.90821492927058770002e-10;
+    static constexpr double Sqrt2 = 1.41421356237309504880;
+
+    static double select(bool condition, double a, double b);
+    static float select(bool condition, float a, float b);
+    static SimdDouble exp(const SimdDouble& input);
+    static SimdFloat exp(const SimdFloat& input);
+    static SimdDouble log(const SimdDouble& x);
+    static SimdFloat log(const SimdFloat& x);
+
+public:
+#ifdef USE_FAST_MATH
+    static constexpr bool Default = true;
+#else
+    static constexpr bool Default = false;
+#endif
+
+    static double Exp(double x);
+    static float Exp(float x);
+    static double Log(double x);
+    static float Log(float x);
+
+    template<typename T> static void Exp(const T x[], T y[], size_t n);
+    template<typename T> static void Log(const T x[], T y[], size_t n);
+    template<typename T> static double LogSumExp(T x[], const T weight[], size_t n, T& sum);
+    template<typename T> static void LogSumExp(T x[], size_t stride, size_t rows, const T weight[], size_t n, T sum[], T result[]);
+};
+
+/**
+ * @brief exp(x) = 2^k * exp(r), k = round(x/ln2), |r| <= ln2/2, exp(r) by its Taylor series to r^11
+ *        k is rounded by adding 1.5*2^52, its integer then sits in the low bits of the sum
+ *
+ * @param x (double)
+ * @return  (double)
+ */
+inline double FastMath::Exp(double x)
+{
+    const double shifter = 6755399441055744.0;
+    double k, r, p;
+    uint64_t bits;
+
+    x = select(x > -708.0, x, -708.0);
+    x = select(x < 708.0, x, 708.0);
+
+    k = x * Log2E + shifter;
+    memcpy(&bits, &k, sizeof(bits));
+    k -= shifter;
+    r = x - k * Ln2Hi - k * Ln2Lo;
+
+    p = 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    // 2^k from the exponent bits
+    bits = (bits - 0x4338000000000000ULL + 1023) << 52;
+    memcpy(&k, &bits, sizeof(k));
+
+    return p * k;
+}
+
+/**
+ * @brief exp(x) in float, Taylor series to r^6
+ *
+ * @param x (float)
+ * @return  (float)
+ */
+inline float FastMath::Exp(float x)
+{
+    const float shifter = 12582912.0f;
+    float k, r, p;
+    uint32_t bits;
+
+    x = select(x > -87.0f, x, -87.0f);
+    x = select(x < 88.0f, x, 88.0f);
+
+    k = x * (float)Log2E + shifter;
+    memcpy(&bits, &k, sizeof(bits));
+    k -= shifter;
+    r = x - k * 0.693145751953125f - k * 1.428606765330187045e-06f;
+
+    p = 1.0f / 720.0f;
+    p = p * r + 1.0f / 120.0f;
+    p = p * r + 1.0f / 24.0f;
+    p = p * r + 1.0f / 6.0f;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+
+    bits = (bits - 0x4B400000U + 127) << 23;
+    memcpy(&k, &bits, sizeof(k));
+
+    return p * k;
+}
+
+/**
+ * @brief log(x) = e*ln2 + log(m), m in [sqrt(1/2), sqrt(2)),
+ *        log(m) = 2*atanh(s) = 2s*(1 + s^2/3 + ... + s^14/15), s = (m-1)/(m+1)
+ *        The exponent is read from the bits with the 2^52 trick, no integer conversion is needed
+ *
+ * @param x (double)
+ * @return  (double)
+ */
+inline double FastMath::Log(double x)
+{
+    double m, e, f, s, s2, p, half, result;
+    uint64_t bits, exponent;
+
+    memcpy(&bits, &x, sizeof(bits));
+    exponent = 0x4330000000000000ULL | (bits >> 52);
+    memcpy(&e, &exponent, sizeof(e));
+    e -= 4503599627371519.0; // 2^52 + 1023
+
+    bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    memcpy(&m, &bits, sizeof(m));
+    half = select(m > Sqrt2, 1.0, 0.0);
+    e += half;
+    m *= 1.0 - 0.5 * half;
+
+    f = m - 1.0;
+    s = f / (2.0 + f);
+    s2 = s * s;
+
+    p = 1.0 / 15.0;
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2;
+
+    result = e * Ln2Hi + ((2.0 * s + 2.0 * s * p) + e * Ln2Lo);
+
+    // NaN below 0, -inf at 0
+    result = select(x >= 0, result, (double)NAN);
+    return select(x == 0, -HUGE_VAL, result);
+}
+
+/**
+ * @brief log(x) in float, series to s^6/7
+ *
+ * @param x (float)
+ * @return  (float)
+ */
+inline float FastMath::Log(float x)
+{
+    float m, e, f, s, s2, p, half, result;
+    uint32_t bits, exponent;
+
+    memcpy(&bits, &x, sizeof(bits));
+    exponent = 0x4B000000U | (bits >> 23);
+    memcpy(&e, &exponent, sizeof(e));
+    e -= 8388735.0f; // 2^23 + 127
+
+    bits = (bits & 0x007FFFFFU) | 0x3F800000U;
+    memcpy(&m, &bits, sizeof(m));
+    half = select(m > (float)Sqrt2, 1.0f, 0.0f);
+    e += half;
+    m *= 1.0f - 0.5f * half;
+
+    f = m - 1.0f;
+    s = f / (2.0f + f);
+    s2 = s * s;
+
+    p = 1.0f / 7.0f;
+    p = p * s2 + 1.0f / 5.0f;
+    p = p * s2 + 1.0f / 3.0f;
+    p = p * s2;
+
+    result = e * 0.693145751953125f + ((2.0f * s + 2.0f * s * p) + e * 1.428606765330187045e-06f);
+
+    result = select(x >= 0, result, (float)NAN);
+    return select(x == 0, -HUGE_VALF, result);
+}
+
+/**
+ * @brief condition ? a : b with bit masks
+ *        A conditional jump, or a floating point operation the compiler moves into one,
+ *        stops the vectorization of the loops above without AVX-512
+ *
+ * @param condition (bool)
+ * @param a         (double)
+ * @param b         (double)
+ * @return          (double)
+ */
+inline double FastMath::select(bool condition, double a, double b)
+{
+    uint64_t bitsA, bitsB, mask = 0 - (uint64_t)condition;
+
+    memcpy(&bitsA, &a, sizeof(bitsA));
+    memcpy(&bitsB, &b, sizeof(bitsB));
+    bitsA = (bitsA & mask) | (bitsB & ~mask);
+    memcpy(&a, &bitsA, sizeof(a));
+
+    return a;
+}
+
+inline float FastMath::select(bool condition, float a, float b)
+{
+    uint32_t bitsA, bitsB, mask = 0 - (uint32_t)condition;
+
+    memcpy(&bitsA, &a, sizeof(bitsA));
+    memcpy(&bitsB, &b, sizeof(bitsB));
+    bitsA = (bitsA & mask) | (bitsB & ~mask);
+    memcpy(&a, &bitsA, sizeof(a));
+
+    return a;
+}
+
+/**
+ * @brief Exp(double) on the lanes of a pack, the same operations in the same order
+ *        2^k is applied by Scale instead of the exponent bits of the scalar version
+ *
+ * @param input (SimdDouble)
+ * @return      (SimdDouble)
+ */
+inline SimdDouble FastMath::exp(const SimdDouble& input)
+{
+    const SimdDouble shifter = SimdDouble::Broadcast(6755399441055744.0);
+    SimdDouble x, k, r, p;
+
+    x = SimdDouble::Max(input, SimdDouble::Broadcast(-708.0));
+    x = SimdDouble::Min(x, SimdDouble::Broadcast(708.0));
+
+    k = (x * Log2E + shifter) - shifter;
+    r = x - k * Ln2Hi - k * Ln2Lo;
+
+    p = SimdDouble::Broadcast(1.0 / 39916800.0);
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    return p.Scale(k);
+}
+
+/**
+ * @brief Exp(float) on the lanes of a pack
+ *
+ * @param input (SimdFloat)
+ * @return      (SimdFloat)
+ */
+inline SimdFloat FastMath::exp(const SimdFloat& input)
+{
+    const SimdFloat shifter = SimdFloat::Broadcast(12582912.0f);
+    SimdFloat x, k, r, p;
+
+    x = SimdFloat::Max(input, SimdFloat::Broadcast(-87.0f));
+    x = SimdFloat::Min(x, SimdFloat::Broadcast(88.0f));
+
+    k = (x * (float)Log2E + shifter) - shifter;
+    r = x - k * 0.693145751953125f - k * 1.428606765330187045e-06f;
+
+    p = SimdFloat::Broadcast(1.0f / 720.0f);
+    p = p * r + 1.0f / 120.0f;
+    p = p * r + 1.0f / 24.0f;
+    p = p * r + 1.0f / 6.0f;
+    p = p * r + 0.5f;
+    p = p * r + 1.0f;
+    p = p * r + 1.0f;
+
+    return p.Scale(k);
+}
+
+/**
+ * @brief Log(double) on the lanes of a pack, exponent and mantissa are split by the pack
+ *
+ * @param x (SimdDouble)
+ * @return  (SimdDouble)
+ */
+inline SimdDouble FastMath::log(const SimdDouble& x)
+{
+    const SimdDouble zero = SimdDouble::Broadcast(0.0), one = SimdDouble::Broadcast(1.0);
+    SimdDouble m, e, f, s, s2, p, half, result;
+
+    e = x.Exponent(m);
+    half = SimdDouble::Select(SimdDouble::Broadcast(Sqrt2), m, one, zero);
+    e = e + half;
+    m = m * (one - 0.5 * half);
+
+    f = m - 1.0;
+    s = f / (f + 2.0);
+    s2 = s * s;
+
+    p = SimdDouble::Broadcast(1.0 / 15.0);
+    p = p * s2 + 1.0 / 13.0;
+    p = p * s2 + 1.0 / 11.0;
+    p = p * s2 + 1.0 / 9.0;
+    p = p * s2 + 1.0 / 7.0;
+    p = p * s2 + 1.0 / 5.0;
+    p = p * s2 + 1.0 / 3.0;
+    p = p * s2;
+
+    result = e * Ln2Hi + ((2.0 * s + 2.0 * s * p) + e * Ln2Lo);
+
+    // -inf at 0, NaN below
+    result = SimdDouble::Select(zero, x, result, SimdDouble::Broadcast(-HUGE_VAL));
+    return SimdDouble::Select(x, zero, SimdDouble::Broadcast(NAN), result);
+}
+
+/**
+ * @brief Log(float) on the lanes of a pack
+ *
+ * @param x (SimdFloat)
+ * @return  (SimdFloat)
+ */
+inline SimdFloat FastMath::log(const SimdFloat& x)
+{
+    const SimdFloat zero = SimdFloat::Broadcast(0.0f), one = SimdFloat::Broadcast(1.0f);
+    SimdFloat m, e, f, s, s2, p, half, result;
+
+    e = x.Exponent(m);
+    half = SimdFloat::Select(SimdFloat::Broadcast((float)Sqrt2), m, one, zero);
+    e = e + half;
+    m = m * (one - 0.5f * half);
+
+    f = m - 1.0f;
+    s = f / (f + 2.0f);
+    s2 = s * s;
+
+    p = SimdFloat::Broadcast(1.0f / 7.0f);
+    p = p * s2 + 1.0f / 5.0f;
+    p = p * s2 + 1.0f / 3.0f;
+    p = p * s2;
+
+    result = e * 0.693145751953125f + ((2.0f * s + 2.0f * s * p) + e * 1.428606765330187045e-06f);
+
+    result = SimdFloat::Select(zero, x, result, SimdFloat::Broadcast(-HUGE_VALF));
+    return SimdFloat::Select(x, zero, SimdFloat::Broadcast(NAN), result);
+}
+
+/**
+ * @brief y[i] = exp(x[i]), x and y may be the same array
+ *
+ * @param x (T)      Input
+ * @param y (T)      Output
+ * @param n (size_t) Number of values
+ */
+template<typename T>
+void FastMath::Exp(const T x[], T y[], size_t n)
+{
+    using Pack = typename SimdPack<T>::Type;
+    size_t blocks = n - n % Pack::Lanes;
+
+    for(size_t i = 0; i < blocks; i += Pack::Lanes)
+    {
+        exp(Pack::Load(&x[i])).Store(&y[i]);
+    }
+    for(size_t i = blocks; i < n; i++)
+    {
+        y[i] = Exp(x[i]);
+    }
+}
+
+/**
+ * @brief y[i] = log(x[i]), x and y may be the same array
+ *
+ * @param x (T)      Input
+ * @param y (T)      Output
+ * @param n (size_t) Number of values
+ */
+template<typename T>
+void FastMath::Log(const T x[], T y[], size_t n)
+{
+    using Pack = typename SimdPack<T>::Type;
+    size_t blocks = n - n % Pack::Lanes;
+
+    for(size_t i = 0; i < blocks; i += Pack::Lanes)
+    {
+        log(Pack::Load(&x[i])).Store(&y[i]);
+    }
+    for(size_t i = blocks; i < n; i++)
+    {
+        y[i] = Log(x[i]);
+    }
+}
+
+/**
+ * @brief log(sum_i weight[i]*exp(x[i])), computed around the largest x so nothing overflows
+ *
+ * @param x      (T)      Exponents (n), replaced by exp(x[i] - max)
+ * @param weight (T)      Weights (n)
+ * @param n      (size_t) Number of values, at least 1
+ * @param sum    (T)      Receives sum_i weight[i]*exp(x[i] - max)
+ * @return       (double) max + log(sum)
+ */
+template<typename T>
+double FastMath::LogSumExp(T x[], const T weight[], size_t n, T& sum)
+{
+    using Pack = typename SimdPack<T>::Type;
+    size_t blocks = n - n % Pack::Lanes;
+    Pack terms = Pack::Broadcast(0), values;
+    T max = x[0];
+
+    for(size_t i = 1; i < n; i++)
+    {
+        max = x[i] > max ? x[i] : max;
+    }
+
+    // Whole packs first, their weighted sum is reduced once
+    for(size_t i = 0; i < blocks; i += Pack::Lanes)
+    {
+        values = exp(Pack::Load(&x[i]) - max);
+        values.Store(&x[i]);
+        terms = terms + Pack::Load(&weight[i]) * values;
+    }
+
+    sum = terms.Sum();
+    for(size_t i = blocks; i < n; i++)
+    {
+        x[i] = Exp((T)(x[i] - max));
+        sum += weight[i] * x[i];
+    }
+
+    return Log((double)sum) + max;
+}
+
+/**
+ * @brief LogSumExp of every row of a matrix, with one Exp over the whole block and Log a pack of rows at a time
+ *        A single row of mixtures is shorter than two packs, this keeps the lanes full.
+ *
+ * @param x      (T)      Exponents (rows x n), replaced by exp(x[i] - max of the row),
+ *                        the padding between the rows is overwritten
+ * @param stride (size_t) Distance between two rows, at least n
+ * @param rows   (size_t) Number of rows
+ * @param weight (T)      Weights (n)
+ * @param n      (size_t) Number of values per row, at least 1
+ * @param sum    (T)      Receives sum_i weight[i]*exp(x[i] - max) of each row (rows)
+ * @param result (T)      Receives max + log(sum) of each row (rows)
+ */
+template<typename T>
+void FastMath::LogSumExp(T x[], size_t stride, size_t rows, const T weight[], size_t n, T sum[], T result[])
+{
+    using Pack = typename SimdPack<T>::Type;
+    size_t blocks = rows - rows % Pack::Lanes;
+    T* row;
+
+    if(rows == 0) return;
+
+    for(size_t r = 0; r < rows; r++)
+    {
+        row = &x[r * stride];
+        result[r] = row[0];
+        for(size_t i = 1; i < n; i++)
+        {
+            result[r] = row[i] > result[r] ? row[i] : result[r];
+        }
+        for(size_t i = 0; i < n; i++)
+        {
+            row[i] -= result[r];
+        }
+    }
+
+    Exp(x, x, (rows - 1) * stride + n);
+
+    for(size_t r = 0; r < rows; r++)
+    {
+        row = &x[r * stride];
+        sum[r] = 0;
+        for(size_t i = 0; i < n; i++)
+        {
+            sum[r] += weight[i] * row[i];
+        }
+    }
+
+    for(size_t r = 0; r < blocks; r += Pack::Lanes)
+    {
+        (Pack::Load(&result[r]) + log(Pack::Load(&sum[r]))).Store(&result[r]);
+    }
+    for(size_t r = blocks; r < rows; r++)
+    {
+        result[r] += Log(sum[r]);
+    }
+}
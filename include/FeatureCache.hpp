@@ -0,0 +1,208 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <stdint.h>
+#include <thread>
+#include <functional>
+#include <filesystem>
+
+#include "FeatureMatrix.hpp"
+
+/**
+ * @brief On-disk store of MFCC matrices, one binary file per key
+ *        The key is a hash of the samples and the front-end settings (MFCC::GetConfigHash),
+ *        so a changed signal or configuration never hits an old file.
+ *        File: magic, version, key, sizeof(T), rows, cols, rows*cols values of T,
+ *              number of speech tags (0 or rows), the tags (see MFCC::setVAD).
+ *
+ */
+class FeatureCache
+{
+private:
+    /* data */
+    std::string m_Directory;
+
+    static constexpr uint32_t Magic = 0x4343464d; // "MFCC"
+    static constexpr uint32_t Version = 2;
+
+public:
+    FeatureCache(const std::string& directory);
+    virtual ~FeatureCache();
+
+    static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+    template<typename T> bool Load(uint64_t key, size_t featureDim, BasicFeatureMatrix<T>& features, std::vector<unsigned char>* speechFlags = nullptr);
+    template<typename T> bool Store(uint64_t key, const BasicFeatureMatrix<T>& features, const std::vector<unsigned char>* speechFlags = nullptr);
+    std::string GetFilePath(uint64_t key);
+};
+
+/**
+ * @brief Construct a new FeatureCache object, the directory is created if needed
+ *
+ * @param directory (string) Location of the cache files
+ */
+FeatureCache::FeatureCache(const std::string& directory) : m_Directory(directory)
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_Directory, error);
+}
+
+FeatureCache::~FeatureCache()
+{
+}
+
+/**
+ * @brief FNV-1a hash of a byte buffer, chain several buffers through seed
+ *
+ * @param data (void)     Bytes to hash
+ * @param size (size_t)   Number of bytes
+ * @param seed (uint64_t) Hash of the previous buffers
+ * @return     (uint64_t)
+ */
+uint64_t FeatureCache::Hash(const void* data, size_t size, uint64_t seed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Reads the features stored for key
+ *        The sizes of the header are checked against featureDim and the length of the file
+ *        before anything is allocated, a truncated or corrupted file is a miss.
+ *
+ * @param key         (uint64_t)      Hash of samples and settings
+ * @param featureDim  (size_t)        Features per frame expected in the file
+ * @param features    (FeatureMatrix) Filled with the stored frames
+ * @param speechFlags (vector)        Filled with the stored speech tags, nullptr if not needed
+ * @return            (bool) False if there is no valid file for key, or it has no speech tags when asked for
+ */
+template<typename T>
+bool FeatureCache::Load(uint64_t key, size_t featureDim, BasicFeatureMatrix<T>& features, std::vector<unsigned char>* speechFlags)
+{
+    uint32_t magic, version, scalarSize;
+    uint64_t fileKey, rows, cols, flagCount = 0, remaining;
+    std::streamoff position;
+
+    std::ifstream inFile(GetFilePath(key), std::ifstream::binary);
+    if(!inFile.is_open())
+        return false;
+
+    inFile.read((char*)&magic, sizeof(magic));
+    inFile.read((char*)&version, sizeof(version));
+    inFile.read((char*)&fileKey, sizeof(fileKey));
+    inFile.read((char*)&scalarSize, sizeof(scalarSize));
+    inFile.read((char*)&rows, sizeof(rows));
+    inFile.read((char*)&cols, sizeof(cols));
+    if(!inFile || magic != Magic || version != Version || fileKey != key || scalarSize != sizeof(T) || cols != featureDim || cols == 0)
+        return false;
+
+    // The frames and the tag count have to be in the rest of the file
+    position = inFile.tellg();
+    inFile.seekg(0, std::ifstream::end);
+    remaining = (uint64_t)(inFile.tellg() - position);
+    inFile.seekg(position);
+    if(!inFile || remaining < sizeof(flagCount) || rows > (remaining - sizeof(flagCount)) / (cols * sizeof(T)))
+        return false;
+
+    features.Clear();
+    features.Resize(rows, cols);
+    for(size_t i = 0; i < rows; i++)
+        inFile.read((char*)features[i], cols * sizeof(T));
+
+    inFile.read((char*)&flagCount, sizeof(flagCount));
+    if(!inFile)
+    {
+        features.Clear();
+        return false;
+    }
+    if(speechFlags != nullptr)
+    {
+        if(flagCount != rows)
+        {
+            features.Clear();
+            return false;
+        }
+        speechFlags->resize(flagCount);
+        inFile.read((char*)speechFlags->data(), flagCount);
+    }
+
+    if(!inFile)
+    {
+        features.Clear();
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Writes the features for key
+ *        The file is written under a temporary name and renamed, so readers
+ *        and other threads storing the same key never see a partial file.
+ *
+ * @param key         (uint64_t)      Hash of samples and settings
+ * @param features    (FeatureMatrix) Frames to store
+ * @param speechFlags (vector)        Speech tags of the frames, nullptr for none
+ * @return            (bool) If operation was successful
+ */
+template<typename T>
+bool FeatureCache::Store(uint64_t key, const BasicFeatureMatrix<T>& features, const std::vector<unsigned char>* speechFlags)
+{
+    uint32_t magic = Magic, version = Version, scalarSize = sizeof(T);
+    uint64_t rows = features.GetRows(), cols = features.GetCols();
+    uint64_t flagCount = speechFlags != nullptr ? std::min((uint64_t)speechFlags->size(), rows) : 0;
+    std::string filePath = GetFilePath(key);
+    std::string tempPath = filePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+    std::ofstream outFile(tempPath, std::ofstream::binary);
+    if(!outFile.is_open())
+        return false;
+
+    outFile.write((const char*)&magic, sizeof(magic));
+    outFile.write((const char*)&version, sizeof(version));
+    outFile.write((const char*)&key, sizeof(key));
+    outFile.write((const char*)&scalarSize, sizeof(scalarSize));
+    outFile.write((const char*)&rows, sizeof(rows));
+    outFile.write((const char*)&cols, sizeof(cols));
+    for(size_t i = 0; i < rows; i++)
+        outFile.write((const char*)features[i], cols * sizeof(T));
+    outFile.write((const char*)&flagCount, sizeof(flagCount));
+    if(flagCount > 0)
+        outFile.write((const char*)speechFlags->data(), flagCount);
+    outFile.close();
+
+    if(!outFile || std::rename(tempPath.c_str(), filePath.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns the file of key: directory/<16 hex digits>.mfc
+ *
+ * @param key (uint64_t)
+ * @return    (string)
+ */
+std::string FeatureCache::GetFilePath(uint64_t key)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "%016llx.mfc", (unsigned long long)key);
+
+    return m_Directory + "/" + name;
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <new>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+/**
+ * @brief Read-only window on rows of a FeatureMatrix, like a span it does not own the data
+ *        speech optionally tags every row as speech (1) or non-speech (0), see MFCC::setVAD
+ *
+ */
+template<typename T>
+struct BasicFeatureView
+{
+    const T* data;
+    size_t rows;
+    size_t cols;
+    size_t stride;
+    const unsigned char* speech;
+
+    BasicFeatureView() : data(nullptr), rows(0), cols(0), stride(0), speech(nullptr) {}
+    BasicFeatureView(const T* data, size_t rows, size_t cols, size_t stride, const unsigned char* speech = nullptr) : data(data), rows(rows), cols(cols), stride(stride), speech(speech) {}
+
+    const T* operator[](size_t row) const { return data + row * stride; }
+    bool IsSpeech(size_t row) const { return speech == nullptr || speech[row] != 0; }
+    BasicFeatureView Slice(size_t first, size_t count) const { return BasicFeatureView(data + first * stride, count, cols, stride, speech != nullptr ? speech + first : nullptr); }
+};
+
+/**
+ * @brief Frames x features matrix in one aligned buffer, T is double or float
+ *
+ */
+template<typename T>
+class BasicFeatureMatrix
+{
+private:
+    /* data */
+    void allocate(size_t rows);
+    void release();
+
+    T* m_Data;
+    size_t m_Rows;
+    size_t m_Cols;
+    size_t m_Stride;
+    size_t m_Capacity;
+
+public:
+    // Rows start on a cache line
+    static constexpr size_t Alignment = 64;
+
+    BasicFeatureMatrix();
+    BasicFeatureMatrix(size_t rows, size_t cols);
+    BasicFeatureMatrix(const BasicFeatureMatrix& other);
+    BasicFeatureMatrix(BasicFeatureMatrix&& other) noexcept;
+    BasicFeatureMatrix& operator=(const BasicFeatureMatrix& other);
+    BasicFeatureMatrix& operator=(BasicFeatureMatrix&& other) noexcept;
+    virtual ~BasicFeatureMatrix();
+
+    void Resize(size_t rows, size_t cols);
+    void Reserve(size_t rows);
+    void Clear();
+
+    size_t GetRows() const;
+    size_t GetCols() const;
+    size_t GetStride() const;
+
+    T* Row(size_t row);
+    const T* Row(size_t row) const;
+    T* operator[](size_t row);
+    const T* operator[](size_t row) const;
+
+    BasicFeatureView<T> View() const;
+    BasicFeatureView<T> View(size_t first, size_t count) const;
+    operator BasicFeatureView<T>() const;
+};
+
+/**
+ * @brief Construct an empty BasicFeatureMatrix object
+ *
+ */
+template<typename T>
+BasicFeatureMatrix<T>::BasicFeatureMatrix() : m_Data(nullptr), m_Rows(0), m_Cols(0), m_Stride(0), m_Capacity(0)
+{
+}
+
+/**
+ * @brief Construct a new BasicFeatureMatrix object filled with zeros
+ *
+ * @param rows (size_t) Number of frames
+ * @param cols (size_t) Number of features per frame
+ */
+template<typename T>
+BasicFeatureMatrix<T>::BasicFeatureMatrix(size_t rows, size_t cols) : BasicFeatureMatrix()
+{
+    Resize(rows, cols);
+}
+
+template<typename T>
+BasicFeatureMatrix<T>::BasicFeatureMatrix(const BasicFeatureMatrix<T>& other) : BasicFeatureMatrix()
+{
+    *this = other;
+}
+
+template<typename T>
+BasicFeatureMatrix<T>::BasicFeatureMatrix(BasicFeatureMatrix<T>&& other) noexcept : BasicFeatureMatrix()
+{
+    *this = std::move(other);
+}
+
+/**
+ * @brief Copies the rows of other, the buffer is reused if it is large enough
+ *
+ * @param other (FeatureMatrix)
+ * @return      (FeatureMatrix)
+ */
+template<typename T>
+BasicFeatureMatrix<T>& BasicFeatureMatrix<T>::operator=(const BasicFeatureMatrix<T>& other)
+{
+    if(this == &other) return *this;
+
+    m_Rows = 0;
+    Resize(other.m_Rows, other.m_Cols);
+    if(m_Rows > 0)
+        memcpy(m_Data, other.m_Data, m_Rows * m_Stride * sizeof(T));
+
+    return *this;
+}
+
+template<typename T>
+BasicFeatureMatrix<T>& BasicFeatureMatrix<T>::operator=(BasicFeatureMatrix<T>&& other) noexcept
+{
+    if(this == &other) return *this;
+
+    release();
+    m_Data = other.m_Data;
+    m_Rows = other.m_Rows;
+    m_Cols = other.m_Cols;
+    m_Stride = other.m_Stride;
+    m_Capacity = other.m_Capacity;
+
+    other.m_Data = nullptr;
+    other.m_Rows = 0;
+    other.m_Capacity = 0;
+
+    return *this;
+}
+
+/**
+ * @brief Destroy the BasicFeatureMatrix object
+ *
+ */
+template<typename T>
+BasicFeatureMatrix<T>::~BasicFeatureMatrix()
+{
+    release();
+}
+
+/**
+ * @brief Changes the size of the matrix
+ *        The rows are kept when the number of features does not change, new rows are zero.
+ *        The buffer grows geometrically, so appending frames one by one is amortized O(1).
+ *
+ * @param rows (size_t) Number of frames
+ * @param cols (size_t) Number of features per frame
+ */
+template<typename T>
+void BasicFeatureMatrix<T>::Resize(size_t rows, size_t cols)
+{
+    size_t stride = (cols + Alignment / sizeof(T) - 1) / (Alignment / sizeof(T)) * (Alignment / sizeof(T));
+
+    if(stride != m_Stride)
+    {
+        release();
+        m_Stride = stride;
+        m_Rows = 0;
+    }
+    m_Cols = cols;
+
+    if(rows > m_Capacity)
+    {
+        allocate(rows > 2 * m_Capacity ? rows : 2 * m_Capacity);
+    }
+    if(rows > m_Rows)
+    {
+        memset(m_Data + m_Rows * m_Stride, 0, (rows - m_Rows) * m_Stride * sizeof(T));
+    }
+    m_Rows = rows;
+}
+
+/**
+ * @brief Allocates room for rows frames without changing the size
+ *
+ * @param rows (size_t)
+ */
+template<typename T>
+void BasicFeatureMatrix<T>::Reserve(size_t rows)
+{
+    if(rows > m_Capacity) allocate(rows);
+}
+
+/**
+ * @brief Removes all rows, the buffer is kept
+ *
+ */
+template<typename T>
+void BasicFeatureMatrix<T>::Clear()
+{
+    m_Rows = 0;
+}
+
+template<typename T>
+size_t BasicFeatureMatrix<T>::GetRows() const
+{
+    return m_Rows;
+}
+
+template<typename T>
+size_t BasicFeatureMatrix<T>::GetCols() const
+{
+    return m_Cols;
+}
+
+/**
+ * @brief Returns the distance between two rows, a multiple of 64 bytes
+ *
+ * @return (size_t)
+ */
+template<typename T>
+size_t BasicFeatureMatrix<T>::GetStride() const
+{
+    return m_Stride;
+}
+
+template<typename T>
+T* BasicFeatureMatrix<T>::Row(size_t row)
+{
+    return m_Data + row * m_Stride;
+}
+
+template<typename T>
+const T* BasicFeatureMatrix<T>::Row(size_t row) const
+{
+    return m_Data + row * m_Stride;
+}
+
+template<typename T>
+T* BasicFeatureMatrix<T>::operator[](size_t row)
+{
+    return m_Data + row * m_Stride;
+}
+
+template<typename T>
+const T* BasicFeatureMatrix<T>::operator[](size_t row) const
+{
+    return m_Data + row * m_Stride;
+}
+
+template<typename T>
+BasicFeatureView<T> BasicFeatureMatrix<T>::View() const
+{
+    return BasicFeatureView<T>(m_Data, m_Rows, m_Cols, m_Stride);
+}
+
+/**
+ * @brief Returns a view on the rows [first, first+count)
+ *
+ * @param first (size_t)
+ * @param count (size_t)
+ * @return      (FeatureView)
+ */
+template<typename T>
+BasicFeatureView<T> BasicFeatureMatrix<T>::View(size_t first, size_t count) const
+{
+    return BasicFeatureView<T>(m_Data + first * m_Stride, count, m_Cols, m_Stride);
+}
+
+template<typename T>
+BasicFeatureMatrix<T>::operator BasicFeatureView<T>() const
+{
+    return View();
+}
+
+/**
+ * @brief Moves the rows into a new aligned buffer of capacity rows
+ *
+ * @param rows (size_t)
+ */
+template<typename T>
+void BasicFeatureMatrix<T>::allocate(size_t rows)
+{
+    T* data = static_cast<T*>(::operator new[](rows * m_Stride * sizeof(T), std::align_val_t(Alignment)));
+
+    if(m_Data != nullptr && m_Rows > 0)
+        memcpy(data, m_Data, m_Rows * m_Stride * sizeof(T));
+
+    if(m_Data != nullptr)
+        ::operator delete[](m_Data, std::align_val_t(Alignment));
+
+    m_Data = data;
+    m_Capacity = rows;
+}
+
+template<typename T>
+void BasicFeatureMatrix<T>::release()
+{
+    if(m_Data != nullptr)
+        ::operator delete[](m_Data, std::align_val_t(Alignment));
+
+    m_Data = nullptr;
+    m_Capacity = 0;
+}
+
+typedef BasicFeatureView<double> FeatureView;
+typedef BasicFeatureView<float> FeatureViewF;
+typedef BasicFeatureMatrix<double> FeatureMatrix;
+typedef BasicFeatureMatrix<float> FeatureMatrixF;
@@ -3,25 +3,57 @@
 #include <math.h>
 #include <vector>
 
+#include "Simd.hpp"
+
 class Filter
 {
 private:
     float alpha = 0.97;
 
+    //Conditioning of a stream, the state is carried across chunks
+    double m_Emphasis;
+    double m_DCPole;
+    double m_PrevInput;
+    double m_PrevOutput;
+
 public:
 
     // Constructor/Destructor
     Filter();
+    Filter(double emphasis, double dcPole);
     ~Filter();
 
     
     std::vector<double> emphasize_signal(std::vector<double> &signal);
     std::vector<double> hamming_window(std::vector<double> &signal);
 
+    void setEmphasis(double emphasis);
+    void setDCRemoval(double pole);
+    double GetEmphasis() const;
+    double GetDCPole() const;
+    bool IsActive() const;
+    void Reset();
+    void Process(const short int input[], size_t size, double output[]);
+    static void Window(const double input[], const double window[], size_t size, double output[]);
 };
 
-Filter::Filter()
+/**
+ * @brief Construct a new Filter object, the conditioning is off
+ * 
+ */
+Filter::Filter() : Filter(0.0, 0.0)
+{
+}
+
+/**
+ * @brief Construct a new Filter object
+ * 
+ * @param emphasis  (double) Pre-emphasis coefficient, y[n] = x[n] - emphasis*x[n-1], 0 = off
+ * @param dcPole    (double) Pole of the DC blocker y[n] = x[n] - x[n-1] + pole*y[n-1], 0 = off
+ */
+Filter::Filter(double emphasis, double dcPole) : m_Emphasis(emphasis), m_DCPole(dcPole)
 {
+    Reset();
 }
 
 Filter::~Filter()
@@ -31,7 +63,7 @@ Filter::~Filter()
 std::vector<double> Filter::emphasize_signal(std::vector<double> &signal)
 {
     std::vector<double> emphasized;
-    for(int i = 0; i < signal.size(); i++){
+    for(size_t i = 0; i < signal.size(); i++){
         if(i == 0)
         {
             emphasized.push_back(signal[i]);
@@ -48,10 +80,119 @@ std::vector<double> Filter::hamming_window(std::vector<double> &signal)
 {
     std::vector<double> window;
 
-    for(int i = 0; i < signal.size(); ++i)
+    for(size_t i = 0; i < signal.size(); ++i)
     {
         window.push_back(0.54 - 0.46 * cos(2*M_PI*i/signal.size()));
     }
 
     return window;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Sets the pre-emphasis coefficient (typically 0.97), 0 turns it off
+ * 
+ * @param emphasis (double)
+ */
+void Filter::setEmphasis(double emphasis)
+{
+    m_Emphasis = emphasis;
+}
+
+/**
+ * @brief Sets the pole of the DC blocker (typically 0.999), 0 turns it off
+ * 
+ * @param pole (double) Closer to 1 keeps more of the low frequencies
+ */
+void Filter::setDCRemoval(double pole)
+{
+    m_DCPole = pole;
+}
+
+double Filter::GetEmphasis() const
+{
+    return m_Emphasis;
+}
+
+double Filter::GetDCPole() const
+{
+    return m_DCPole;
+}
+
+/**
+ * @brief Returns false if Process only converts the samples
+ * 
+ * @return (bool)
+ */
+bool Filter::IsActive() const
+{
+    return m_Emphasis != 0.0 || m_DCPole != 0.0;
+}
+
+/**
+ * @brief Starts a new stream, the samples before it are taken as 0
+ * 
+ */
+void Filter::Reset()
+{
+    m_PrevInput = 0.0;
+    m_PrevOutput = 0.0;
+}
+
+/**
+ * @brief Removes the DC offset and applies the pre-emphasis in one pass over the samples
+ *        Chunks of a stream can have any size, the result is the same as for the whole signal.
+ *        Without DC blocker there is no recursion and the loop is vectorized.
+ * 
+ * @param input  (short int) Samples of the next chunk
+ * @param size   (size_t)    Number of samples
+ * @param output (double)    Conditioned samples (size)
+ */
+void Filter::Process(const short int input[], size_t size, double output[])
+{
+    double dc, prev;
+
+    if(size == 0) return;
+
+    if(m_DCPole == 0.0)
+    {
+        // Pre-emphasis only (or plain conversion), every output depends on the input only
+        output[0] = input[0] - m_Emphasis * m_PrevInput;
+        for(size_t i = 1; i < size; i++)
+        {
+            output[i] = input[i] - m_Emphasis * input[i - 1];
+        }
+        m_PrevInput = input[size - 1];
+        return;
+    }
+
+    // DC blocker and pre-emphasis of its output
+    prev = m_PrevOutput;
+    for(size_t i = 0; i < size; i++)
+    {
+        dc = input[i] - m_PrevInput + m_DCPole * prev;
+        output[i] = dc - m_Emphasis * prev;
+        m_PrevInput = input[i];
+        prev = dc;
+    }
+    m_PrevOutput = prev;
+}
+
+/**
+ * @brief Multiplies conditioned samples with the window coefficients, Lanes of SimdDouble at a time
+ *        The frames overlap, so every sample is windowed by up to FrameSize/FrameShift frames with
+ *        different coefficients: this runs per frame on the output of Process, not per sample in it.
+ * 
+ * @param input  (double) Conditioned samples
+ * @param window (double) Window coefficients
+ * @param size   (size_t) Number of samples
+ * @param output (double) Windowed samples (size)
+ */
+void Filter::Window(const double input[], const double window[], size_t size, double output[])
+{
+    size_t blocks = size - size % SimdDouble::Lanes;
+
+    for(size_t i = 0; i < blocks; i += SimdDouble::Lanes)
+        (SimdDouble::Load(&input[i]) * SimdDouble::Load(&window[i])).Store(&output[i]);
+    for(size_t i = blocks; i < size; i++)
+        output[i] = input[i] * window[i];
+}
@@ -2,108 +2,274 @@
 
 #include<string>
 #include<vector>
-#include<map>
 #include <algorithm>
 #include <iomanip>
 #include <fstream>
+#include <cstring>
 #include <math.h>
+#include <float.h>
 
 #include "Kmeans.hpp"
+#include "FeatureMatrix.hpp"
+#include "FastMath.hpp"
+#include "ModelStore.hpp"
+#include "ThreadPool.hpp"
+#include "CMVN.hpp"
 
+template<typename T>
 struct Model
 {
-    std::vector<double> weight;
-    std::vector<std::vector<double> > mean;
-    std::vector<std::vector<double> > covariance;
-    std::vector<std::vector<double> > invert_covariance;
-    std::vector<double> ExpCoeff;
+    std::vector<T> weight;
+    std::vector<std::vector<T> > mean;
+    std::vector<std::vector<T> > covariance;
+    std::vector<std::vector<T> > invert_covariance;
+    std::vector<T> ExpCoeff;
+    // Exponent of every component as a product with the frame [x^2, x, 1] (2*MfccDim+1 x MixDim)
+    BasicFeatureMatrix<T> QuadCoeff;
 };
 
-class GMM
+template<typename T>
+class BasicGMM
 {
 private:
     /* data */
-    Model newModel();
-    void delModel(Model model);
-    void completeModel(Model& model);
-    double Likelihood(const std::vector<std::vector<double>>& melCepData, size_t frameCount, Model model, std::vector<std::vector<double>>& normProb, std::vector<double>& mixedProb);
+    // Buffers of one scoring thread, they grow to the longest utterance only
+    struct Scratch
+    {
+        BasicFeatureMatrix<T> expMatrix;
+        BasicFeatureMatrix<T> normProb;
+        std::vector<T> maxMatrix;
+        std::vector<T> mixedProb;
+        std::vector<T> mixWeight;
+        std::vector<double> partial;
+    };
+
+    // Sufficient statistics of the EM over a shard of frames, component j in column j
+    struct Statistics
+    {
+        std::vector<double> count;                  // posteriors (MixDim)
+        std::vector<std::vector<double>> sum;       // posterior * x (MfccDim x MixDim)
+        std::vector<std::vector<double>> square;    // posterior * x^2 (MfccDim x MixDim)
+    };
+
+    Model<T> newModel();
+    void delModel(Model<T>& model);
+    void completeModel(Model<T>& model);
+    void expandModel(Model<T>& model);
+    BasicModelView<T> viewModel(const Model<T>& model);
+    double Likelihood(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const BasicModelView<T>& model, const T* selected, Scratch& scratch, ThreadPool* pool);
+    double likelihoodChunk(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const BasicModelView<T>& model, Scratch& scratch);
+    double likelihoodSelected(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const T* selected, Scratch& scratch);
+    void quantizeFrames(const BasicFeatureView<T>& melCepData, size_t first, size_t frameCount);
+    void prepareScratch(Scratch& scratch, size_t frameCount);
+    void resetStatistics(Statistics& statistics);
+    void accumulateStatistics(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, Scratch& scratch, Statistics& statistics);
+    void scoreModels(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const std::vector<int>& ids, std::vector<double>& scores);
+    std::string classifyBeam(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    void expandFrames(const BasicFeatureView<T>& melCepData, size_t frameCount, BasicFeatureMatrix<T>& expanded);
+    void scoreFrames(const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const BasicModelView<T>& model, BasicFeatureMatrix<T>& expMatrix);
+    T frameWeight(const BasicFeatureView<T>& melCepData, size_t frame);
+    BasicFeatureView<T> selectFrames(const BasicFeatureView<T>& melCepData, size_t frameCount);
 
     int m_MixDim;
     int m_MfccDim;
     double m_Threshold;
+    int m_Converged;
     double m_MinCov;
-    Model m_Model;
+    Model<T> m_Model;
     int number_gaussian_components;
-    std::map<std::string, Model> m_Models;
+    BasicModelStore<T> m_Models;
+    bool m_FastMath;
+    int m_FrameSelection;
+    double m_NonSpeechWeight;
+
+    //Classify session, likelihoods in the order of the model IDs
+    std::vector<double> m_SessionLikelihood;
+    size_t m_SessionFrames;
+
+    //Scoring, one scratch per worker of m_ThreadPool
+    ThreadPool* m_ThreadPool;
+    std::vector<Scratch> m_Scratch;
+    BasicFeatureMatrix<T> m_Expanded;
+    std::vector<double> m_Scores;
+    std::vector<int> m_ModelIds;
+
+    //Trainning, statistics of the EM per worker of m_ThreadPool and their sum over all shards
+    std::vector<Statistics> m_Statistics;
+    Statistics m_Total;
+
+    //Beam search of Classify, models further than m_Beam below the leader are dropped
+    double m_Beam;
+    size_t m_BeamBlock;
+    size_t m_Pruned;
+    std::vector<int> m_Active;
+    std::vector<double> m_BeamScores;
+
+    //Gaussian selection, per model and codeword the QuadCoeff columns of the shortlist
+    //(2*MfccDim+1 x m_ShortlistSize) followed by their mixture weights, see BuildGaussianSelection
+    BasicFeatureMatrix<T> m_Codebook;
+    std::vector<T> m_Selected;
+    int m_ShortlistSize;
+    double m_SelectionFloor;
+    std::vector<int> m_FrameCode;
+
+    //Normalization of the features the models are trained on, kept in the model files
+    BasicCMVN<T>* m_CMVN;
 
     const double PI2 = 6.28318530717958647692;
 
 public:
-    GMM();
-    virtual ~GMM();
-
-    int Expectation_Maximation(const std::vector<std::vector<double> > melCepData, size_t frameCount);
-    std::string Classify(const std::vector<std::vector<double> > &melCepData, size_t frameCount);
-    double Likelihood(const std::vector<std::vector<double> > &melCepData, size_t frameCount);
+    // Use of the speech tags of the frames (FeatureView::speech, see MFCC::setVAD)
+    enum FrameSelection
+    {
+        AllFrames,
+        SkipNonSpeech,
+        WeightNonSpeech
+    };
+
+    BasicGMM();
+    BasicGMM(int mixDim, int mfccDim);
+    virtual ~BasicGMM();
+
+    int Expectation_Maximation(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    int GetConvergedIteration();
+    std::string Classify(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    std::vector<double> Score(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    size_t GetModelCount();
+    std::string GetModelName(size_t id);
+    void StartClassify();
+    void AddFrames(const BasicFeatureView<T>& melCepData);
+    std::string GetBest();
+    std::vector<std::pair<std::string, double>> GetNBest(size_t n);
+    size_t GetSessionFrames();
+    double Likelihood(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    void setFrameSelection(FrameSelection selection, double weight = 0.1);
+    void setFastMath(bool enable);
+    void setThreadPool(ThreadPool* pool);
+    void setCMVN(BasicCMVN<T>* cmvn);
+    void setBeam(double beam, size_t blockFrames = 20);
+    size_t GetPrunedCount();
+    bool BuildGaussianSelection(int codewords, int shortlist, double floor = 20.0);
+    void ClearGaussianSelection();
+    int GetSelectedComponents();
     bool LoadModel(const std::string& filePath);
     bool SaveModel(const std::string& filePath);
     bool AddModel(const std::string& name);
     bool AddModel(const std::string& filePath, const std::string& name);
+
+    // Frames per task of the frame-parallel likelihood and EM, the partial sums are added in this order
+    static constexpr size_t FrameChunk = 512;
+    // Kmeans iterations of the Gaussian selection codebook
+    static constexpr int CodebookIterations = 20;
 };
 
 /**
- * @brief Construct a new GMM::GMM object
+ * @brief Construct a new BasicGMM object
  * 
  */
-GMM::GMM()
+template<typename T>
+BasicGMM<T>::BasicGMM() : BasicGMM(12, 12)
+{
+}
+
+/**
+ * @brief Construct a new BasicGMM object
+ * 
+ * @param mixDim  (int) Number of gaussian components
+ * @param mfccDim (int) Number of features per frame, MFCC::GetFeatureDim with deltas
+ */
+template<typename T>
+BasicGMM<T>::BasicGMM(int mixDim, int mfccDim) : m_Models(mixDim, mfccDim)
 {
     // Set the mfcc dimension
     // Set the mixture dimensions
-    m_MixDim = 12;
-    m_MfccDim= 12;
+    m_MixDim = mixDim;
+    m_MfccDim= mfccDim;
 
     // Set break statement for testing
     m_Threshold = 0.005;
+    m_Converged = 0;
     m_MinCov = 0.015;
+    m_SessionFrames = 0;
+    m_FrameSelection = AllFrames;
+    m_NonSpeechWeight = 0.1;
+    m_FastMath = FastMath::Default;
+    m_ThreadPool = nullptr;
+    m_Scratch.resize(1);
+    m_ShortlistSize = 0;
+    m_SelectionFloor = 20.0;
+    m_Beam = 0;
+    m_BeamBlock = 20;
+    m_Pruned = 0;
+    m_CMVN = nullptr;
 
     // Create Models
     m_Model = newModel();
 }
 
-GMM::~GMM()
+template<typename T>
+BasicGMM<T>::~BasicGMM()
 {
     delModel(m_Model);
-
-    std::map<std::string, Model>::const_iterator it = m_Models.begin();
-    while(it != m_Models.end())
-    {
-        delModel(it->second);
-        ++it;
-    }
-    m_Models.clear();
+    m_Models.Clear();
 }
 
 /**
  * @brief Train the GMM with EM-Algorithm
  *        E: estimation step
  *        M: maximation step
+ *        Non-speech frames are left out or down-weighted according to setFrameSelection.
+ *        With fewer speech frames than components all frames are trained.
+ *        The E step sums the statistics of each shard of FrameChunk frames on the workers of
+ *        setThreadPool, one shard per worker at a time, and they are reduced in the order of the
+ *        shards: the model does not depend on the number of workers.
+ *        A component without posteriors keeps its mean and covariance, its weight becomes 0.
  * 
- * @param melCepData (2d-vector) matrix contains the frames with features: melCepData(frames x 39)
+ * @param frames     (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
  * @param frameCount (size_t) number of frames 
- * @return (int) number of training iterations
+ * @return (int) number of training iterations, 0 with fewer frames than components (the model is unchanged)
  */
-int GMM::Expectation_Maximation(const std::vector<std::vector<double> > melCepData, size_t frameCount)
+template<typename T>
+int BasicGMM<T>::Expectation_Maximation(const BasicFeatureView<T>& frames, size_t frameCount)
 {
     int step;
 	int iteration = 0;
 	double newProb;
 	double recentProb = 0.0;
+    double weightSum = 0.0;
+    T weight;
+
+    BasicFeatureView<T> melCepData = selectFrames(frames, frameCount);
+    std::vector<size_t> scored;
 
-    std::vector<double> sumProb(m_MixDim);
-    std::vector<double> mixedProb(frameCount);
-    std::vector<std::vector<double>> normProb(frameCount, std::vector<double>(m_MixDim));
-    std::vector<std::vector<double>> tempProb(m_MfccDim, std::vector<double>(m_MixDim));
-    std::vector<std::vector<double>> squareCep(frameCount, std::vector<double>(m_MfccDim));
+    size_t shardCount = (frameCount + FrameChunk - 1) / FrameChunk;
+    size_t workers = m_ThreadPool != nullptr && m_ThreadPool->GetWorkerCount() > 1 ? m_ThreadPool->GetWorkerCount() : 1;
+    Scratch& scratch = m_Scratch[0];
+    BasicFeatureMatrix<T> expanded;
+
+    // Frames taking part in the training, the means start on them
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        weight = frameWeight(melCepData, i);
+        if(weight == 0) continue;
+        weightSum += weight;
+        scored.push_back(i);
+    }
+
+    // Fewer speech frames than components: all frames, like an utterance without speech
+    if(scored.size() < (size_t)m_MixDim && melCepData.speech != nullptr)
+    {
+        melCepData.speech = nullptr;
+        scored.clear();
+        weightSum = 0.0;
+        for(size_t i = 0; i < frameCount; i++)
+        {
+            weightSum += frameWeight(melCepData, i);
+            scored.push_back(i);
+        }
+    }
+    m_Converged = 0;
+    if(scored.size() < (size_t)m_MixDim) return 0;
 
 	//*** Initialization
 	for(int i = 0; i < m_MixDim; i++)
@@ -111,14 +277,13 @@ int GMM::Expectation_Maximation(const std::vector<std::vector<double> > melCepDa
 		m_Model.weight[i] = 1.0 / m_MixDim;
     }
 
-
-    step = (int)floor(frameCount / m_MixDim);
+    step = (int)floor(scored.size() / m_MixDim);
 
 	for(int j = 0; j < m_MixDim; j++)
     {
         for(int i = 0; i < m_MfccDim; i++)
         {
-            m_Model.mean[i][j] = melCepData[step * (j + 1) -1][i];
+            m_Model.mean[i][j] = melCepData[scored[step * (j + 1) -1]][i];
         }
     }
 
@@ -130,13 +295,15 @@ int GMM::Expectation_Maximation(const std::vector<std::vector<double> > melCepDa
         }
     }
 
-    for(size_t i = 0; i < frameCount; i++)
-    {
-        for(int j = 0; j < m_MfccDim; j++)
-        {
-            squareCep[i][j] = melCepData[i][j] * melCepData[i][j];
-        }
-    }
+    // [x^2, x, 1] of every frame, the squares are also the second moments of the M step
+    expandFrames(melCepData, frameCount, expanded);
+    prepareScratch(scratch, frameCount);
+
+    // One set of statistics per worker, the workers do not allocate
+    if(m_Statistics.size() < workers)
+        m_Statistics.resize(workers);
+    for(size_t w = 0; w < workers; w++)
+        resetStatistics(m_Statistics[w]);
 
 
     // Iterative processing
@@ -144,160 +311,544 @@ int GMM::Expectation_Maximation(const std::vector<std::vector<double> > melCepDa
 	while(true)
 	{
 	    completeModel(m_Model);
-	    newProb = Likelihood(melCepData, frameCount, m_Model, normProb, mixedProb);
+	    newProb = Likelihood(melCepData, expanded, 0, frameCount, viewModel(m_Model), nullptr, scratch, m_ThreadPool);
 
-        // E process, a probability matrix, n*m_MixDim
-	   	for(size_t i = 0; i < frameCount; i++)
+        // E process, rounds of one shard per worker, the posteriors of each shard summed into the
+        // statistics of its place in the round and reduced in the order of the shards
+        resetStatistics(m_Total);
+        for(size_t round = 0; round < shardCount; round += workers)
         {
-		    for(int j = 0; j < m_MixDim; j++)
-			{
-               	normProb[i][j] *= m_Model.weight[j] / mixedProb[i];
-            }
-        }
+            size_t count = std::min(workers, shardCount - round);
 
-        // M process
-	    for(int i = 0; i < m_MixDim; i++)
-		{
-		   	sumProb[i] = 0.0;
-		   	for(size_t j = 0; j < frameCount; j++)
+            if(count > 1)
             {
-                sumProb[i] += normProb[j][i];
+                m_ThreadPool->ParallelFor(count, [&](size_t w, int)
+                {
+                    size_t c = round + w;
+                    accumulateStatistics(melCepData, expanded, c * FrameChunk, std::min(FrameChunk, frameCount - c * FrameChunk), scratch, m_Statistics[w]);
+                });
+            }
+            else
+            {
+                accumulateStatistics(melCepData, expanded, round * FrameChunk, std::min(FrameChunk, frameCount - round * FrameChunk), scratch, m_Statistics[0]);
             }
-		}
-
-        // renew mixture coefficients
-	   	for(int i = 0; i < m_MixDim; i++)
-        {
-		   	m_Model.weight[i] = sumProb[i] / frameCount;
-        }
-
-        // renew mean
-		for(int i = 0; i < m_MfccDim; i++)
-        {
-			for(int j = 0; j < m_MixDim; j++)
-			{
-				tempProb[i][j] = 0.0;
-				for(size_t k = 0; k < frameCount; k++)
-			    	tempProb[i][j] += melCepData[k][i] * normProb[k][j];
-
-				m_Model.mean[i][j] = tempProb[i][j] / sumProb[j];
-			}
-        }
 
-        // renew covariance
-	   	for(int i = 0; i < m_MixDim; i++)
-        {
-		   	for(int j = 0; j < m_MfccDim; j++)
+            for(size_t w = 0; w < count; w++)
             {
-                tempProb[j][i] = 0.0;
-                for(size_t k = 0; k < frameCount; k++)
+                for(int j = 0; j < m_MixDim; j++)
                 {
-                    tempProb[j][i] += squareCep[k][j] * normProb[k][i];
+                    m_Total.count[j] += m_Statistics[w].count[j];
+                    for(int k = 0; k < m_MfccDim; k++)
+                    {
+                        m_Total.sum[k][j] += m_Statistics[w].sum[k][j];
+                        m_Total.square[k][j] += m_Statistics[w].square[k][j];
+                    }
                 }
-                tempProb[j][i] = tempProb[j][i] / sumProb[i];
             }
         }
 
-        // set covariance
+        // M process, renew mixture coefficients, mean and covariance
 	   	for(int i = 0; i < m_MixDim; i++)
         {
-	     	for(int j = 0; j < m_MfccDim; j++)
+		   	m_Model.weight[i] = m_Total.count[i] / weightSum;
+            if(m_Total.count[i] < DBL_MIN) continue;
+
+			for(int j = 0; j < m_MfccDim; j++)
 			{
-		   		m_Model.covariance[i][j] = tempProb[j][i] - m_Model.mean[j][i] * m_Model.mean[j][i];
+				m_Model.mean[j][i] = m_Total.sum[j][i] / m_Total.count[i];
+		   		m_Model.covariance[i][j] = m_Total.square[j][i] / m_Total.count[i] - m_Model.mean[j][i] * m_Model.mean[j][i];
 			   	if(m_Model.covariance[i][j] <= m_MinCov)
                 {
                     m_Model.covariance[i][j] = m_MinCov;
                 }
 			}
         }
+        // First iteration gaining less than m_Threshold of the likelihood, the loop still runs all of them
+        if(m_Converged == 0 && iteration > 0 && fabs(newProb - recentProb) < m_Threshold * fabs(recentProb))
+            m_Converged = iteration;
+
         // prepare for next iteration
 	  	recentProb = newProb;
         iteration++;
         if(iteration > 19)  break;
 	}
 
-	tempProb.clear();
-	normProb.clear();
-	sumProb.clear();
-	mixedProb.clear();
+    // Scoring with the last means, invert_covariance stays the one of the last E step
+    expandModel(m_Model);
 
     return iteration;
 }
 
+/**
+ * @brief Returns the iteration of the last Expectation_Maximation at which the likelihood
+ *        first changed by less than 0.5 %, a measure of the convergence of the trainning data
+ * 
+ * @return (int) 0 if it was not reached
+ */
+template<typename T>
+int BasicGMM<T>::GetConvergedIteration()
+{
+    return m_Converged;
+}
+
 /**
  * @brief Decoder of the GMM
+ *        The models are scored on the workers of setThreadPool, the best one is chosen
+ *        afterwards in the order of the IDs: the result does not depend on the number of workers,
+ *        on equal scores the model added last wins. With setBeam the models are scored block by
+ *        block and the hopeless ones are dropped early (see classifyBeam).
  * 
- * @param melCepData (2d-vector) matrix contains the frames with features: melCepData(frames x 39)
+ * @param frames     (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
  * @param frameCount (size_t) number of frames 
  * @return (string) returns the recognized name
  */
-std::string GMM::Classify(const std::vector<std::vector<double> >& melCepData, size_t frameCount)
+template<typename T>
+std::string BasicGMM<T>::Classify(const BasicFeatureView<T>& frames, size_t frameCount)
 {
-    double likelihood;
+    BasicFeatureView<T> melCepData = selectFrames(frames, frameCount);
     double probMax = 0;
     std::string name;
     bool first = true;
 
-    std::vector<double> mixedProb;
-    std::vector<std::vector<double> > normProb;
+    m_Pruned = 0;
+    if(m_Beam > 0) return classifyBeam(melCepData, frameCount);
 
-    std::map<std::string, Model>::const_iterator it = m_Models.begin();
-    std::map<std::string, Model>::const_iterator itEnd = m_Models.end();
+    // The frames are expanded once for all models
+    expandFrames(melCepData, frameCount, m_Expanded);
+    scoreModels(melCepData, m_Expanded, 0, frameCount, m_ModelIds, m_Scores);
 
-    mixedProb.resize(frameCount);
-    normProb.resize(frameCount);
+    for(size_t id = 0; id < m_Scores.size(); id++)
+    {
+        if((first == true) || (probMax <= m_Scores[id]))
+        {
+            probMax = m_Scores[id];
+            name = m_Models.GetLabel((int)id);
+            first = false;
+        }
+    }
 
-    for(size_t i = 0; i < frameCount; i++)
+    return name;
+}
+
+/**
+ * @brief Block synchronous decoder with beam pruning
+ *        All models are scored on blocks of m_BeamBlock frames and their log-likelihoods accumulated.
+ *        After each block every model more than m_Beam below the leader is dropped, the search
+ *        stops when only one is left. The leader of the full utterance can only be lost if it
+ *        was behind by more than the beam at the end of a block.
+ * 
+ * @param melCepData  (FeatureView) Selected frames (see selectFrames)
+ * @param frameCount  (size_t) number of frames 
+ * @return (string) returns the recognized name, GetPrunedCount models were dropped
+ */
+template<typename T>
+std::string BasicGMM<T>::classifyBeam(const BasicFeatureView<T>& melCepData, size_t frameCount)
+{
+    double leader = 0;
+    std::string name;
+    size_t count, kept, n;
+
+    expandFrames(melCepData, frameCount, m_Expanded);
+    m_Active = m_ModelIds;
+    m_BeamScores.assign(m_Models.GetCount(), 0.0);
+
+    for(size_t first = 0; first < frameCount && m_Active.size() > 1; first += count)
+    {
+        count = std::min(m_BeamBlock, frameCount - first);
+        scoreModels(melCepData, m_Expanded, first, count, m_Active, m_Scores);
+
+        for(n = 0; n < m_Active.size(); n++)
+        {
+            m_BeamScores[m_Active[n]] += m_Scores[m_Active[n]];
+            if(n == 0 || leader < m_BeamScores[m_Active[n]]) leader = m_BeamScores[m_Active[n]];
+        }
+
+        // The survivors stay in the order of the IDs
+        for(n = 0, kept = 0; n < m_Active.size(); n++)
+        {
+            if(m_BeamScores[m_Active[n]] >= leader - m_Beam) m_Active[kept++] = m_Active[n];
+        }
+        m_Active.resize(kept);
+    }
+    m_Pruned = m_Models.GetCount() - m_Active.size();
+
+    for(n = 0; n < m_Active.size(); n++)
+    {
+        if((n == 0) || (leader <= m_BeamScores[m_Active[n]]))
+        {
+            leader = m_BeamScores[m_Active[n]];
+            name = m_Models.GetLabel(m_Active[n]);
+        }
+    }
+
+    return name;
+}
+
+/**
+ * @brief Scores the utterance with every model, like Classify
+ * 
+ * @param frames     (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
+ * @param frameCount (size_t) number of frames 
+ * @return (vector) log-likelihood of every model, in the order of the IDs (see GetModelName)
+ */
+template<typename T>
+std::vector<double> BasicGMM<T>::Score(const BasicFeatureView<T>& frames, size_t frameCount)
+{
+    BasicFeatureView<T> melCepData = selectFrames(frames, frameCount);
+    std::vector<double> scores;
+
+    expandFrames(melCepData, frameCount, m_Expanded);
+    scoreModels(melCepData, m_Expanded, 0, frameCount, m_ModelIds, scores);
+
+    return scores;
+}
+
+/**
+ * @brief Returns the number of models added by AddModel
+ * 
+ * @return (size_t)
+ */
+template<typename T>
+size_t BasicGMM<T>::GetModelCount()
+{
+    return m_Models.GetCount();
+}
+
+/**
+ * @brief Returns the number of models dropped by the beam in the last Classify, 0 without beam
+ * 
+ * @return (size_t)
+ */
+template<typename T>
+size_t BasicGMM<T>::GetPrunedCount()
+{
+    return m_Pruned;
+}
+
+/**
+ * @brief Returns the name of a model, the IDs follow the order of the first AddModel of each name
+ * 
+ * @param id (size_t) 0..GetModelCount()-1
+ * @return   (string)
+ */
+template<typename T>
+std::string BasicGMM<T>::GetModelName(size_t id)
+{
+    return m_Models.GetLabel((int)id);
+}
+
+/**
+ * @brief Starts a frame synchronous classification
+ *        The session keeps the log-likelihood of every model, AddFrames only scores the new frames.
+ *        Models added after the start are not part of the session.
+ * 
+ */
+template<typename T>
+void BasicGMM<T>::StartClassify()
+{
+    m_SessionLikelihood.assign(m_Models.GetCount(), 0.0);
+    m_SessionFrames = 0;
+}
+
+/**
+ * @brief Adds the next frames of the utterance to the session
+ *        With SkipNonSpeech the non-speech frames are not scored, even if the chunk has no speech.
+ * 
+ * @param melCepData (FeatureView) new frames (frames x MFCCDim)
+ */
+template<typename T>
+void BasicGMM<T>::AddFrames(const BasicFeatureView<T>& melCepData)
+{
+    size_t frameCount = melCepData.rows;
+    size_t i = 0;
+
+    if(frameCount == 0 || m_SessionLikelihood.size() != m_Models.GetCount()) return;
+
+    expandFrames(melCepData, frameCount, m_Expanded);
+    scoreModels(melCepData, m_Expanded, 0, frameCount, m_ModelIds, m_Scores);
+
+    for(; i < m_SessionLikelihood.size(); i++)
     {
-        normProb[i].resize(m_MixDim);
+        m_SessionLikelihood[i] += m_Scores[i];
     }
 
-    while(it != itEnd)
+    for(i = 0; i < frameCount; i++)
     {
-        likelihood = Likelihood(melCepData, frameCount, it->second, normProb, mixedProb);
+        if(frameWeight(melCepData, i) != 0) m_SessionFrames++;
+    }
+}
 
-        if((first == true) || (probMax <= likelihood))
+/**
+ * @brief Returns the best model of the session, like Classify on all frames added so far
+ * 
+ * @return (string) name of the model, empty without scored frames
+ */
+template<typename T>
+std::string BasicGMM<T>::GetBest()
+{
+    double probMax = 0;
+    std::string name;
+    bool first = true;
+    size_t i = 0;
+
+    if(m_SessionFrames == 0) return name;
+
+    for(; i < m_SessionLikelihood.size(); i++)
+    {
+        if((first == true) || (probMax <= m_SessionLikelihood[i]))
         {
-            probMax = likelihood;
-            name = it->first;
+            probMax = m_SessionLikelihood[i];
+            name = m_Models.GetLabel((int)i);
             first = false;
         }
-        ++it;
     }
 
-    normProb.clear();
-	mixedProb.clear();
-
     return name;
 }
 
+/**
+ * @brief Returns the n best models of the session with their log-likelihood
+ * 
+ * @param n (size_t) number of models
+ * @return  (vector) name and log-likelihood, best first
+ */
+template<typename T>
+std::vector<std::pair<std::string, double>> BasicGMM<T>::GetNBest(size_t n)
+{
+    std::vector<std::pair<std::string, double>> nBest;
+    size_t i = 0;
+
+    if(m_SessionFrames == 0) return nBest;
+
+    for(; i < m_SessionLikelihood.size(); i++)
+    {
+        nBest.push_back(std::make_pair(m_Models.GetLabel((int)i), m_SessionLikelihood[i]));
+    }
+
+    n = std::min(n, nBest.size());
+    std::partial_sort(nBest.begin(), nBest.begin() + n, nBest.end(), [](const std::pair<std::string, double>& p1, const std::pair<std::string, double>& p2) { return p1.second > p2.second; });
+    nBest.resize(n);
+
+    return nBest;
+}
+
+/**
+ * @brief Returns the number of frames scored since StartClassify
+ * 
+ * @return (size_t)
+ */
+template<typename T>
+size_t BasicGMM<T>::GetSessionFrames()
+{
+    return m_SessionFrames;
+}
+
 /**
  * @brief Calculates the Probability for each frame
  * 
- * @param melCepData (2d-vector) matrix contains the frames with features: melCepData(frames x 39)
+ * @param melCepData (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
  * @param frameCount (size_t) number of frames 
  * @return (double) returns probability  
  */
-double GMM::Likelihood(const std::vector<std::vector<double> >& melCepData, size_t frameCount)
+template<typename T>
+double BasicGMM<T>::Likelihood(const BasicFeatureView<T>& melCepData, size_t frameCount)
 {
-    double prob;
-    std::vector<double> mixedProb;
-    std::vector<std::vector<double> > normProb;
+    expandFrames(melCepData, frameCount, m_Expanded);
+    prepareScratch(m_Scratch[0], frameCount);
 
-    mixedProb.resize(frameCount);
-    normProb.resize(frameCount);
+    return Likelihood(selectFrames(melCepData, frameCount), m_Expanded, 0, frameCount, viewModel(m_Model), nullptr, m_Scratch[0], m_ThreadPool);
+}
+
+/**
+ * @brief Sets the use of the speech tags of the frames in scoring and trainning
+ *        AllFrames ignores the tags (default), SkipNonSpeech leaves the non-speech frames out,
+ *        WeightNonSpeech counts them with weight. An utterance without any speech frame
+ *        is scored and trained on all frames.
+ * 
+ * @param selection (enum)   AllFrames, SkipNonSpeech, WeightNonSpeech
+ * @param weight    (double) Weight of a non-speech frame for WeightNonSpeech (0..1)
+ */
+template<typename T>
+void BasicGMM<T>::setFrameSelection(FrameSelection selection, double weight)
+{
+    m_FrameSelection = selection;
+    m_NonSpeechWeight = std::max(0.0, std::min(weight, 1.0));
+}
 
-    for(size_t i = 0; i<frameCount; i++)
+/**
+ * @brief Evaluates the mixtures with the polynomial exp and log of FastMath instead of libm
+ *        The log-likelihoods differ by about 1e-14 relative (double), see FastMath for the bounds.
+ * 
+ * @param enable (bool)
+ */
+template<typename T>
+void BasicGMM<T>::setFastMath(bool enable)
+{
+    m_FastMath = enable;
+}
+
+/**
+ * @brief Scores the models of Classify, Score and AddFrames on the workers of pool
+ *        Every worker gets its own scratch buffers. Long utterances are also split into chunks
+ *        of FrameChunk frames (Likelihood, Expectation_Maximation and fewer models than workers),
+ *        the E step of Expectation_Maximation sums its statistics per chunk.
+ *        The scores are the same as without pool.
+ * 
+ * @param pool (ThreadPool) Workers, nullptr to score on the calling thread (default)
+ */
+template<typename T>
+void BasicGMM<T>::setThreadPool(ThreadPool* pool)
+{
+    m_ThreadPool = pool;
+}
+
+/**
+ * @brief Keeps the global statistics of the feature normalization with the models
+ *        SaveModel writes them into every model file. LoadModel reads them into cmvn for the
+ *        first model and afterwards only accepts models trained with the same statistics,
+ *        so all models of a set are scored on features normalized like their trainning data.
+ *        The features are not normalized here, see CMVN::Accumulate and CMVN::Apply.
+ * 
+ * @param cmvn (CMVN) Statistics, nullptr for models of raw features (default)
+ */
+template<typename T>
+void BasicGMM<T>::setCMVN(BasicCMVN<T>* cmvn)
+{
+    m_CMVN = cmvn;
+}
+
+/**
+ * @brief Classify scores the models in blocks of frames and drops those behind the leader by more than beam
+ *        Score, AddFrames and the sessions are not pruned.
+ * 
+ * @param beam        (double) Log-likelihood below the leader, summed over the frames so far, 0 to score all models on all frames (default)
+ * @param blockFrames (size_t) Frames per block, 20 frames are 200 ms with a shift of 10 ms
+ */
+template<typename T>
+void BasicGMM<T>::setBeam(double beam, size_t blockFrames)
+{
+    m_Beam = std::max(0.0, beam);
+    m_BeamBlock = std::max<size_t>(1, blockFrames);
+}
+
+/**
+ * @brief Builds the Gaussian selection of the models added so far
+ *        The means of all their components are clustered with Kmeans into a codebook, seeded by
+ *        k-means++ picks (the means come sorted by model). Every model keeps, per codeword, the
+ *        shortlist components of highest weighted density at the codeword, their columns of
+ *        QuadCoeff and weights are copied into one block per model and codeword.
+ *        Classify, Score and AddFrames then quantize each frame once and evaluate only the
+ *        shortlist of its codeword, every other component counts as the best weighted one
+ *        times exp(-floor). AddModel clears the selection.
+ *        The blocks take models * codewords * shortlist * (2*MfccDim+2) values of T.
+ * 
+ * @param codewords (int)    Size of the codebook, at most the number of components of all models
+ * @param shortlist (int)    Components evaluated per frame and model (1..MixDim)
+ * @param floor     (double) Log-ratio of the best shortlisted component to each component outside the shortlist
+ * @return          (bool)   False without models
+ */
+template<typename T>
+bool BasicGMM<T>::BuildGaussianSelection(int codewords, int shortlist, double floor)
+{
+    size_t modelCount = m_Models.GetCount();
+    const int dim = 2 * m_MfccDim + 1;
+    size_t blockSize;
+    std::vector<std::vector<double>> means;
+    std::vector<std::pair<double, int>> ranked(m_MixDim);
+
+    ClearGaussianSelection();
+    if(modelCount == 0 || codewords < 1 || shortlist < 1) return false;
+
+    ///*** Means of all components, from the coefficients inv and -2*inv*mean
+    for(size_t m = 0; m < modelCount; m++)
+    {
+        BasicModelView<T> model = m_Models.View((int)m);
+
+        for(int j = 0; j < m_MixDim; j++)
+        {
+            std::vector<double> mean(m_MfccDim);
+
+            for(int k = 0; k < m_MfccDim; k++)
+                mean[k] = -model.QuadRow(m_MfccDim + k)[j] / (2.0 * model.QuadRow(k)[j]);
+            means.push_back(mean);
+        }
+    }
+
+    ///*** Codebook
+    codewords = std::min(codewords, (int)means.size());
+    Kmeans kmeans(m_MfccDim, codewords);
+    kmeans.InitializePlusPlus((int)means.size(), means);
+    for(int i = 0; i < CodebookIterations; i++)
     {
-        normProb[i].resize(m_MixDim);
+        if(kmeans.Cluster((int)means.size(), means) < 1e-9) break;
     }
 
-    prob = Likelihood(melCepData, frameCount, m_Model, normProb, mixedProb);
+    m_Codebook.Resize(codewords, m_MfccDim);
+    for(int c = 0; c < codewords; c++)
+        for(int k = 0; k < m_MfccDim; k++)
+            m_Codebook[c][k] = kmeans.centroid[c][k];
 
-    normProb.clear();
-	mixedProb.clear();
+    ///*** Shortlists, the components ranked by log(weight * density) at the codeword
+    m_ShortlistSize = std::min(shortlist, m_MixDim);
+    m_SelectionFloor = floor;
+    blockSize = (size_t)(dim + 1) * m_ShortlistSize;
+    m_Selected.resize(modelCount * codewords * blockSize);
 
-    return prob;
+    for(size_t m = 0; m < modelCount; m++)
+    {
+        BasicModelView<T> model = m_Models.View((int)m);
+
+        for(int c = 0; c < codewords; c++)
+        {
+            T* block = &m_Selected[(m * codewords + c) * blockSize];
+
+            for(int j = 0; j < m_MixDim; j++)
+            {
+                double score = model.QuadRow(2 * m_MfccDim)[j] + log((double)model.weight[j] * model.expCoeff[j]);
+
+                for(int k = 0; k < m_MfccDim; k++)
+                    score += (model.QuadRow(k)[j] * m_Codebook[c][k] + model.QuadRow(m_MfccDim + k)[j]) * m_Codebook[c][k];
+                ranked[j] = std::make_pair(-score, j);
+            }
+
+            std::partial_sort(ranked.begin(), ranked.begin() + m_ShortlistSize, ranked.end());
+
+            // Row k of the block holds coefficient k of the shortlist, the weights follow
+            for(int s = 0; s < m_ShortlistSize; s++)
+            {
+                int j = ranked[s].second;
+
+                for(int k = 0; k < dim; k++)
+                    block[k * m_ShortlistSize + s] = model.QuadRow(k)[j];
+                block[dim * m_ShortlistSize + s] = model.expCoeff[j] * model.weight[j];
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Returns the number of components evaluated per frame and model by Classify, Score and AddFrames
+ * 
+ * @return (int) shortlist of BuildGaussianSelection, MixDim without selection
+ */
+template<typename T>
+int BasicGMM<T>::GetSelectedComponents()
+{
+    return m_Selected.empty() ? m_MixDim : m_ShortlistSize;
+}
+
+/**
+ * @brief Evaluates all components again
+ * 
+ */
+template<typename T>
+void BasicGMM<T>::ClearGaussianSelection()
+{
+    m_Codebook.Clear();
+    m_Selected.clear();
+    m_ShortlistSize = 0;
 }
 
 /**
@@ -306,7 +857,8 @@ double GMM::Likelihood(const std::vector<std::vector<double> >& melCepData, size
  * @param filePath (string) Filepath to save location
  * @return  true if the action was successful
  */
-bool GMM::SaveModel(const std::string& filePath)
+template<typename T>
+bool BasicGMM<T>::SaveModel(const std::string& filePath)
 {
     std::ofstream outFile(filePath);
     if(!outFile.is_open())
@@ -348,17 +900,25 @@ bool GMM::SaveModel(const std::string& filePath)
         outFile << std::endl;
     }
 
+    if(m_CMVN != nullptr)
+    {
+        outFile << "cmvn:" << std::endl;
+        m_CMVN->Write(outFile);
+    }
+
     outFile.close();
     return true;
 }
 
 /**
  * @brief Model loader from save location
+ *        With setCMVN the file has to hold the statistics of the set, see setCMVN.
  * 
  * @param filePath (string) File path to saved location
  * @return  true if the action was successful
  */
-bool GMM::LoadModel(const std::string& filePath)
+template<typename T>
+bool BasicGMM<T>::LoadModel(const std::string& filePath)
 {
     std::string title;
 
@@ -392,40 +952,42 @@ bool GMM::LoadModel(const std::string& filePath)
         }
     }
 
-    inFile.close();
     completeModel(m_Model);
+
+    // The first model sets the statistics of the set, the others have to match them
+    if(m_CMVN != nullptr)
+    {
+        BasicCMVN<T> statistics(m_MfccDim);
+        BasicCMVN<T>& target = m_CMVN->GetFrameCount() == 0 ? *m_CMVN : statistics;
+
+        inFile >> title;
+        if(title != "cmvn:" || !target.Read(inFile))
+            return false;
+        if(&target == &statistics && !m_CMVN->Matches(statistics))
+            return false;
+    }
+
+    inFile.close();
     return true;
 }
 
 /**
- * @brief Create new statistical Model with initial parameters
+ * @brief Adds the current model to the classifier, a known name gets the new model
  * 
- * @param word (string) 
+ * @param word (string) Name of the model
  * @return
  */
-bool GMM::AddModel(const std::string& word)
+template<typename T>
+bool BasicGMM<T>::AddModel(const std::string& word)
 {
-    // Create new Model
-    Model model;
-    model = newModel();
-
-    for(int i = 0; i < m_MixDim; i++)
-    {
-        model.weight[i] = m_Model.weight[i];
-        model.ExpCoeff[i] = m_Model.ExpCoeff[i];
-    }
-
-    for(int i = 0; i < m_MfccDim; i++)
-    {
-        for(int j = 0; j < m_MixDim; j++)
-        {
-            model.mean[i][j] = m_Model.mean[i][j];
-            model.covariance[j][i] = m_Model.covariance[j][i];
-            model.invert_covariance[j][i] = m_Model.invert_covariance[j][i];
-        }
-    }
+    // Only the scoring parameters are kept, packed into the store
+    expandModel(m_Model);
+    m_Models.Add(word, viewModel(m_Model));
+    ClearGaussianSelection();
 
-    m_Models[word] = model;
+    m_ModelIds.resize(m_Models.GetCount());
+    for(size_t id = 0; id < m_ModelIds.size(); id++)
+        m_ModelIds[id] = (int)id;
 
     return true;
 }
@@ -437,7 +999,8 @@ bool GMM::AddModel(const std::string& word)
  * @param word     (string) 
  * @return
  */
-bool GMM::AddModel(const std::string& filePath, const std::string& word)
+template<typename T>
+bool BasicGMM<T>::AddModel(const std::string& filePath, const std::string& word)
 {
     if(!LoadModel(filePath))
     {
@@ -452,65 +1015,527 @@ bool GMM::AddModel(const std::string& filePath, const std::string& word)
 
 /**
  * @brief Computes the Likelihoof for each frame
+ *        The frames are scored in chunks of FrameChunk, on the workers of pool for long utterances.
+ *        The partial log-likelihoods are added in the order of the chunks, so the result is the
+ *        same with and without pool. Up to FrameChunk frames it is the sum frame by frame.
  * 
- * @param melCepData (double)   2D Matrix of MFCC data
- * @param frameCount (size_t)   Number of frames
- * @param model      (struct)   Struct of GMM Models
- * @param normProb   (double)   2D Matrix of NormalPrabability
- * @param mixedProb  (double)   Vector of mixed Probability
+ * @param melCepData (FeatureView) Matrix of MFCC data (frames x MFCCDim)
+ * @param expanded   (FeatureMatrix) The frames as [x^2, x, 1], see expandFrames
+ * @param first      (size_t)   First frame
+ * @param frameCount (size_t)   Number of frames from first
+ * @param model      (ModelView) Scoring parameters, see viewModel and BasicModelStore
+ * @param selected   (T)        Shortlist blocks of the model per codeword (see BuildGaussianSelection),
+ *                              nullptr to evaluate all components
+ * @param scratch    (Scratch)  Buffers prepared for first+frameCount, receives the NormalPrabability
+ *                              (normProb, frames x MixDim, not with a shortlist) and the mixed Probability (mixedProb)
+ * @param pool       (ThreadPool) Workers for the chunks, nullptr inside a task of a pool
  * @return           (double)   Likelihood
  */
-double GMM::Likelihood(const std::vector<std::vector<double> > &melCepData, size_t frameCount, Model model, std::vector<std::vector<double> > &normProb, std::vector<double> &mixedProb)
+template<typename T>
+double BasicGMM<T>::Likelihood(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const BasicModelView<T>& model, const T* selected, Scratch& scratch, ThreadPool* pool)
 {
-	double prob = 0.0;
-    std::vector<double> maxMatrix(frameCount);
-    std::vector<std::vector<double> > expMatrix(frameCount, std::vector<double>(m_MixDim, 0));
+    size_t chunkCount = (frameCount + FrameChunk - 1) / FrameChunk;
+    double prob = 0.0;
 
+    // Weights of the log-sum-exp, the mixture weight with the gaussian normalisation
+    for(int j = 0; j < m_MixDim && m_FastMath && selected == nullptr; j++)
+    {
+        scratch.mixWeight[j] = model.expCoeff[j] * model.weight[j];
+    }
 
-    for(size_t i = 0; i < frameCount; i++ )
+    // The chunks write disjoint rows of the scratch
+    if(pool != nullptr && pool->GetWorkerCount() > 1 && chunkCount > 1)
     {
-        for(int j = 0; j < m_MixDim; j++)
+        pool->ParallelFor(chunkCount, [&](size_t c, int)
         {
-            for(int k = 0; k < m_MfccDim; k++)
-            {
-                expMatrix[i][j] += (pow((melCepData[i][k] - model.mean[k][j]),2 )) * model.invert_covariance[j][k];
-            }
+            size_t offset = c * FrameChunk, count = std::min(FrameChunk, frameCount - offset);
+
+            if(selected != nullptr)
+                scratch.partial[c] = likelihoodSelected(melCepData, expanded, first + offset, count, selected, scratch);
+            else
+                scratch.partial[c] = likelihoodChunk(melCepData, expanded, first + offset, count, model, scratch);
+        });
+    }
+    else
+    {
+        for(size_t c = 0; c < chunkCount; c++)
+        {
+            size_t offset = c * FrameChunk, count = std::min(FrameChunk, frameCount - offset);
+
+            if(selected != nullptr)
+                scratch.partial[c] = likelihoodSelected(melCepData, expanded, first + offset, count, selected, scratch);
+            else
+                scratch.partial[c] = likelihoodChunk(melCepData, expanded, first + offset, count, model, scratch);
         }
     }
 
-    for(size_t i = 0; i < frameCount; i++)
+    for(size_t c = 0; c < chunkCount; c++)
     {
-        auto it = max_element(expMatrix[i].begin(), expMatrix[i].end());
+        prob += scratch.partial[c];
+    }
+
+    return prob;
+}
+
+/**
+ * @brief Computes the Likelihoof of the frames [first, first+frameCount)
+ *        The exponents of all frames come from one matrix product with Model::QuadCoeff (scoreFrames).
+ *        The log-likelihood of each frame is weighted by frameWeight, frames of weight 0
+ *        are left out of the sum and get zero probabilities.
+ * 
+ * @param melCepData (FeatureView) Matrix of MFCC data (frames x MFCCDim)
+ * @param expanded   (FeatureMatrix) The frames as [x^2, x, 1], see expandFrames
+ * @param first      (size_t)   First frame
+ * @param frameCount (size_t)   Number of frames
+ * @param model      (ModelView) Scoring parameters
+ * @param scratch    (Scratch)  Buffers, only the rows of the frames are written
+ * @return           (double)   Likelihood of the frames, summed in frame order
+ */
+template<typename T>
+double BasicGMM<T>::likelihoodChunk(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const BasicModelView<T>& model, Scratch& scratch)
+{
+	double prob = 0.0;
+    size_t end = first + frameCount;
+    T weight;
+
+    BasicFeatureMatrix<T>& expMatrix = scratch.expMatrix;
+    BasicFeatureMatrix<T>& normProb = scratch.normProb;
+    std::vector<T>& maxMatrix = scratch.maxMatrix;
+    std::vector<T>& mixedProb = scratch.mixedProb;
+    const std::vector<T>& mixWeight = scratch.mixWeight;
+
+    // Exponents of all frames and components in one matrix product
+    scoreFrames(expanded, first, frameCount, model, expMatrix);
+
+    for(size_t i = first; i < end && !m_FastMath; i++)
+    {
+        auto it = std::max_element(expMatrix[i], expMatrix[i] + m_MixDim);
         maxMatrix[i] = *it;
     }
 
-    // calculate Probability for each frame 
-    for(size_t i = 0; i < frameCount; i++)
+    // All frames of the chunk at once, maxMatrix receives the log-likelihoods
+    if(m_FastMath)
+        FastMath::LogSumExp(expMatrix[first], expMatrix.GetStride(), frameCount, mixWeight.data(), m_MixDim, &mixedProb[first], &maxMatrix[first]);
+
+    // calculate Probability for each frame, the log-likelihood is summed in double
+    for(size_t i = first; i < end; i++)
     {
+        weight = frameWeight(melCepData, i);
+        if(weight == 0)
+        {
+            mixedProb[i] = 0.0;
+            for(int j = 0; j < m_MixDim; j++)
+                normProb[i][j] = 0;
+            continue;
+        }
+
+        if(m_FastMath)
+        {
+            prob += weight * maxMatrix[i];
+            for(int j = 0; j < m_MixDim; j++)
+                normProb[i][j] = expMatrix[i][j] * model.expCoeff[j];
+            continue;
+        }
+
         mixedProb[i] = 0.0;
         for(int j = 0; j < m_MixDim; j++)
         {
             expMatrix[i][j] = exp(expMatrix[i][j] - maxMatrix[i]);
-            normProb[i][j] = expMatrix[i][j] * model.ExpCoeff[j];
+            normProb[i][j] = expMatrix[i][j] * model.expCoeff[j];
             mixedProb[i] = mixedProb[i] + normProb[i][j] * model.weight[j];
         }
-        prob += log(mixedProb[i]) + maxMatrix[i];
+        prob += weight * (log((double)mixedProb[i]) + maxMatrix[i]);
     }
 
-	expMatrix.clear();
-	maxMatrix.clear();
+    return prob;
+}
+
+/**
+ * @brief Computes the Likelihoof of the frames [first, first+frameCount) with the shortlist of their codeword
+ *        Only the shortlisted components are evaluated, the block of the codeword is read row by row
+ *        so the exponents of the shortlist are accumulated side by side from contiguous coefficients.
+ *        Every other component counts as the best weighted one times exp(-m_SelectionFloor).
+ * 
+ * @param melCepData (FeatureView) Matrix of MFCC data (frames x MFCCDim)
+ * @param expanded   (FeatureMatrix) The frames as [x^2, x, 1], see expandFrames
+ * @param first      (size_t)   First frame
+ * @param frameCount (size_t)   Number of frames
+ * @param selected   (T)        Shortlist blocks of the model, one per codeword (see m_Selected)
+ * @param scratch    (Scratch)  Buffers, only the rows of the frames are written
+ * @return           (double)   Likelihood of the frames, summed in frame order
+ */
+template<typename T>
+double BasicGMM<T>::likelihoodSelected(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const T* selected, Scratch& scratch)
+{
+	double prob = 0.0;
+    const int dim = 2 * m_MfccDim + 1;
+    const size_t blockSize = (size_t)(dim + 1) * m_ShortlistSize;
+    const T floorFactor = (T)exp(-m_SelectionFloor);
+    T max, best, term, weight;
+
+    for(size_t i = first; i < first + frameCount; i++)
+    {
+        const T* block = selected + (size_t)m_FrameCode[i] * blockSize;
+        const T* mixWeight = block + (size_t)dim * m_ShortlistSize;
+        const T* x = expanded[i];
+        T* exponent = scratch.expMatrix[i];
+
+        scratch.mixedProb[i] = 0.0;
+        weight = frameWeight(melCepData, i);
+        if(weight == 0) continue;
+
+        // Same summation order per component as a dot product, the inner loop is vectorized
+        std::fill(exponent, exponent + m_ShortlistSize, (T)0);
+        for(int k = 0; k < dim; k++)
+        {
+            const T a = x[k];
+            const T* q = block + (size_t)k * m_ShortlistSize;
+
+            for(int s = 0; s < m_ShortlistSize; s++)
+            {
+                exponent[s] += a * q[s];
+            }
+        }
+
+        max = *std::max_element(exponent, exponent + m_ShortlistSize);
+        best = 0;
+        for(int s = 0; s < m_ShortlistSize; s++)
+        {
+            T value = exponent[s] - max;
+
+            term = mixWeight[s] * (m_FastMath ? FastMath::Exp(value) : (T)exp(value));
+            scratch.mixedProb[i] += term;
+            best = std::max(best, term);
+        }
+        // Each component left out counts as the best one times exp(-floor)
+        scratch.mixedProb[i] += (m_MixDim - m_ShortlistSize) * floorFactor * best;
+
+        prob += weight * ((m_FastMath ? FastMath::Log((double)scratch.mixedProb[i]) : log((double)scratch.mixedProb[i])) + max);
+    }
 
     return prob;
 }
 
+/**
+ * @brief Finds the nearest codeword of the frames [first, first+frameCount) (euclidean distance)
+ * 
+ * @param melCepData (FeatureView) Matrix of MFCC data (frames x MFCCDim)
+ * @param first      (size_t)      First frame
+ * @param frameCount (size_t)      Number of frames
+ */
+template<typename T>
+void BasicGMM<T>::quantizeFrames(const BasicFeatureView<T>& melCepData, size_t first, size_t frameCount)
+{
+    if(m_FrameCode.size() < first + frameCount)
+        m_FrameCode.resize(first + frameCount);
+
+    for(size_t i = first; i < first + frameCount; i++)
+    {
+        double min = 0;
+
+        for(size_t c = 0; c < m_Codebook.GetRows(); c++)
+        {
+            double distance = 0;
+
+            for(int k = 0; k < m_MfccDim; k++)
+            {
+                double diff = melCepData[i][k] - m_Codebook[c][k];
+                distance += diff * diff;
+            }
+            if(c == 0 || distance < min)
+            {
+                min = distance;
+                m_FrameCode[i] = (int)c;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Returns the scoring parameters of a training model, valid while it is not resized
+ * 
+ * @param model (struct) Model with QuadCoeff, weight and ExpCoeff
+ * @return      (ModelView)
+ */
+template<typename T>
+BasicModelView<T> BasicGMM<T>::viewModel(const Model<T>& model)
+{
+    return BasicModelView<T>(model.QuadCoeff[0], model.weight.data(), model.ExpCoeff.data(), model.QuadCoeff.GetStride());
+}
+
+/**
+ * @brief Grows the buffers of a scratch to frameCount frames
+ * 
+ * @param scratch    (Scratch)
+ * @param frameCount (size_t) Number of frames
+ */
+template<typename T>
+void BasicGMM<T>::prepareScratch(Scratch& scratch, size_t frameCount)
+{
+    if(scratch.expMatrix.GetRows() < frameCount)
+    {
+        scratch.expMatrix.Resize(frameCount, m_MixDim);
+        scratch.normProb.Resize(frameCount, m_MixDim);
+        scratch.maxMatrix.resize(frameCount);
+        scratch.mixedProb.resize(frameCount);
+        scratch.partial.resize((frameCount + FrameChunk - 1) / FrameChunk);
+    }
+    scratch.mixWeight.resize(m_MixDim);
+}
+
+/**
+ * @brief Sizes the statistics for the model and sets them to 0, allocates only the first time
+ * 
+ * @param statistics (Statistics)
+ */
+template<typename T>
+void BasicGMM<T>::resetStatistics(Statistics& statistics)
+{
+    statistics.count.assign(m_MixDim, 0.0);
+    statistics.sum.resize(m_MfccDim);
+    statistics.square.resize(m_MfccDim);
+    for(int k = 0; k < m_MfccDim; k++)
+    {
+        statistics.sum[k].assign(m_MixDim, 0.0);
+        statistics.square[k].assign(m_MixDim, 0.0);
+    }
+}
+
+/**
+ * @brief E step of the frames [first, first+frameCount) after Likelihood of the training model
+ *        The normal probabilities become the posteriors of the components, weighted by the frame,
+ *        and are summed into the statistics frame by frame.
+ * 
+ * @param melCepData (FeatureView)   Matrix of MFCC data (frames x MFCCDim)
+ * @param expanded   (FeatureMatrix) The frames as [x^2, x, 1], the squares are the second moments
+ * @param first      (size_t)        First frame
+ * @param frameCount (size_t)        Number of frames
+ * @param scratch    (Scratch)       normProb and mixedProb of Likelihood, only the rows of the frames are used
+ * @param statistics (Statistics)    Receives the sums of the frames, see resetStatistics
+ */
+template<typename T>
+void BasicGMM<T>::accumulateStatistics(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, Scratch& scratch, Statistics& statistics)
+{
+    BasicFeatureMatrix<T>& normProb = scratch.normProb;
+    T weight;
+
+    resetStatistics(statistics);
+
+    for(size_t i = first; i < first + frameCount; i++)
+    {
+        weight = frameWeight(melCepData, i);
+        for(int j = 0; j < m_MixDim; j++)
+        {
+            normProb[i][j] = weight == 0 ? 0 : normProb[i][j] * (weight * m_Model.weight[j] / scratch.mixedProb[i]);
+
+            statistics.count[j] += normProb[i][j];
+            for(int k = 0; k < m_MfccDim; k++)
+            {
+                statistics.sum[k][j] += melCepData[i][k] * normProb[i][j];
+                statistics.square[k][j] += expanded[i][k] * normProb[i][j];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Scores the frames [first, first+frameCount) with the models ids, on the workers of m_ThreadPool if set
+ *        One model is one task, each worker scores with its own scratch. The score of a model
+ *        does not depend on the worker, so the result is the same for any number of workers.
+ *        With fewer models than workers the frames of each model are split instead.
+ * 
+ * @param melCepData (FeatureView)   Matrix of MFCC data (frames x MFCCDim)
+ * @param expanded   (FeatureMatrix) The frames as [x^2, x, 1], see expandFrames
+ * @param first      (size_t)        First frame
+ * @param frameCount (size_t)        Number of frames from first
+ * @param ids        (vector)        IDs of the models to score, m_ModelIds for all
+ * @param scores     (vector)        Receives the log-likelihood of the models at their ID, sized to the
+ *                                   number of models, the other entries are kept
+ */
+template<typename T>
+void BasicGMM<T>::scoreModels(const BasicFeatureView<T>& melCepData, const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const std::vector<int>& ids, std::vector<double>& scores)
+{
+    size_t count = ids.size();
+    size_t modelBlocks = m_Codebook.GetRows() * (size_t)(2 * m_MfccDim + 2) * m_ShortlistSize;
+    const T* selected = m_Selected.empty() ? nullptr : m_Selected.data();
+
+    scores.resize(m_Models.GetCount(), 0.0);
+
+    // Each frame is quantized once for all models
+    if(selected != nullptr)
+        quantizeFrames(melCepData, first, frameCount);
+
+    // Fewer models than workers: one model after the other, each split into frame chunks
+    if(m_ThreadPool == nullptr || m_ThreadPool->GetWorkerCount() < 2 || count < (size_t)m_ThreadPool->GetWorkerCount())
+    {
+        prepareScratch(m_Scratch[0], first + frameCount);
+        for(size_t n = 0; n < count; n++)
+            scores[ids[n]] = Likelihood(melCepData, expanded, first, frameCount, m_Models.View(ids[n]), selected != nullptr ? selected + ids[n] * modelBlocks : nullptr, m_Scratch[0], m_ThreadPool);
+        return;
+    }
+
+    // The buffers are grown here, the workers do not allocate
+    if(m_Scratch.size() < (size_t)m_ThreadPool->GetWorkerCount())
+        m_Scratch.resize(m_ThreadPool->GetWorkerCount());
+    for(size_t i = 0; i < m_Scratch.size(); i++)
+        prepareScratch(m_Scratch[i], first + frameCount);
+
+    m_ThreadPool->ParallelFor(count, [&](size_t n, int worker)
+    {
+        scores[ids[n]] = Likelihood(melCepData, expanded, first, frameCount, m_Models.View(ids[n]), selected != nullptr ? selected + ids[n] * modelBlocks : nullptr, m_Scratch[worker], nullptr);
+    });
+}
+
+/**
+ * @brief Writes every frame as [x^2, x, 1], the left side of the product with Model::QuadCoeff
+ * 
+ * @param melCepData (FeatureView)   Matrix of MFCC data (frames x MFCCDim)
+ * @param frameCount (size_t)        Number of frames
+ * @param expanded   (FeatureMatrix) Expanded frames (frames x 2*MFCCDim+1), resized if needed
+ */
+template<typename T>
+void BasicGMM<T>::expandFrames(const BasicFeatureView<T>& melCepData, size_t frameCount, BasicFeatureMatrix<T>& expanded)
+{
+    if(expanded.GetRows() < frameCount || expanded.GetCols() != (size_t)(2 * m_MfccDim + 1))
+        expanded.Resize(frameCount, 2 * m_MfccDim + 1);
+
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        const T* x = melCepData[i];
+        T* row = expanded[i];
+
+        for(int k = 0; k < m_MfccDim; k++)
+        {
+            row[k] = x[k] * x[k];
+            row[m_MfccDim + k] = x[k];
+        }
+        row[2 * m_MfccDim] = 1;
+    }
+}
+
+/**
+ * @brief expMatrix = expanded * QuadCoeff, the exponents of the frames [first, first+frameCount)
+ *        Four frames by one cache line of components are summed in registers: the inner
+ *        loops have a constant trip count and are vectorized, QuadCoeff stays in L1.
+ *        The padding columns of the rows are computed too, QuadCoeff is zero there.
+ * 
+ * @param expanded   (FeatureMatrix) Expanded frames (frames x 2*MFCCDim+1)
+ * @param first      (size_t)        First frame
+ * @param frameCount (size_t)        Number of frames
+ * @param model      (ModelView)     Scoring parameters
+ * @param expMatrix  (FeatureMatrix) Exponents (frames x MixDim)
+ */
+template<typename T>
+void BasicGMM<T>::scoreFrames(const BasicFeatureMatrix<T>& expanded, size_t first, size_t frameCount, const BasicModelView<T>& model, BasicFeatureMatrix<T>& expMatrix)
+{
+    constexpr int Width = BasicFeatureMatrix<T>::Alignment / sizeof(T);
+    const int dim = 2 * m_MfccDim + 1;
+    const size_t stride = expMatrix.GetStride();
+    const size_t end = first + frameCount;
+    size_t i = first;
+
+    for(; i + 4 <= end; i += 4)
+    {
+        const T *x0 = expanded[i], *x1 = expanded[i + 1], *x2 = expanded[i + 2], *x3 = expanded[i + 3];
+
+        for(size_t c = 0; c < stride; c += Width)
+        {
+            T y0[Width] = {}, y1[Width] = {}, y2[Width] = {}, y3[Width] = {};
+
+            for(int k = 0; k < dim; k++)
+            {
+                const T* q = model.QuadRow(k) + c;
+                T a0 = x0[k], a1 = x1[k], a2 = x2[k], a3 = x3[k];
+
+                for(int w = 0; w < Width; w++)
+                {
+                    y0[w] += a0 * q[w];
+                    y1[w] += a1 * q[w];
+                    y2[w] += a2 * q[w];
+                    y3[w] += a3 * q[w];
+                }
+            }
+
+            memcpy(&expMatrix[i][c], y0, sizeof(y0));
+            memcpy(&expMatrix[i + 1][c], y1, sizeof(y1));
+            memcpy(&expMatrix[i + 2][c], y2, sizeof(y2));
+            memcpy(&expMatrix[i + 3][c], y3, sizeof(y3));
+        }
+    }
+
+    for(; i < end; i++)
+    {
+        const T* x = expanded[i];
+
+        for(size_t c = 0; c < stride; c += Width)
+        {
+            T y[Width] = {};
+
+            for(int k = 0; k < dim; k++)
+            {
+                const T* q = model.QuadRow(k) + c;
+                T a = x[k];
+
+                for(int w = 0; w < Width; w++)
+                {
+                    y[w] += a * q[w];
+                }
+            }
+
+            memcpy(&expMatrix[i][c], y, sizeof(y));
+        }
+    }
+}
+
+/**
+ * @brief Returns the weight of a frame in scoring and trainning
+ * 
+ * @param melCepData (FeatureView) Frames with their speech tags
+ * @param frame      (size_t)      Row of the frame
+ * @return           (T)           1 for speech and without tags, 0 or the non-speech weight else
+ */
+template<typename T>
+T BasicGMM<T>::frameWeight(const BasicFeatureView<T>& melCepData, size_t frame)
+{
+    if(m_FrameSelection == AllFrames || melCepData.IsSpeech(frame))
+        return 1;
+
+    return m_FrameSelection == SkipNonSpeech ? 0 : (T)m_NonSpeechWeight;
+}
+
+/**
+ * @brief Drops the speech tags of an utterance without any speech frame, so it is used entirely
+ * 
+ * @param melCepData (FeatureView) Frames with their speech tags
+ * @param frameCount (size_t)      Number of frames
+ * @return           (FeatureView)
+ */
+template<typename T>
+BasicFeatureView<T> BasicGMM<T>::selectFrames(const BasicFeatureView<T>& melCepData, size_t frameCount)
+{
+    BasicFeatureView<T> frames = melCepData;
+
+    if(m_FrameSelection == AllFrames || melCepData.speech == nullptr)
+        return frames;
+
+    for(size_t i = 0; i < frameCount; i++)
+    {
+        if(melCepData.speech[i]) return frames;
+    }
+
+    frames.speech = nullptr;
+    return frames;
+}
+
 /**
  * @brief Creates new Initial GMM Model
  * 
  * @return New GMM model with initial parameters
  */
-Model GMM::newModel()
+template<typename T>
+Model<T> BasicGMM<T>::newModel()
 {
-    Model model;
+    Model<T> model;
 
     model.weight.resize(m_MixDim);
     model.mean.resize(m_MfccDim);
@@ -531,6 +1556,7 @@ Model GMM::newModel()
     }
 
     model.ExpCoeff.resize(m_MixDim);
+    model.QuadCoeff.Resize(2 * m_MfccDim + 1, m_MixDim);
 
     return model;
 }
@@ -540,13 +1566,15 @@ Model GMM::newModel()
  * 
  * @param model (struct) struct of models
  */
-void GMM::delModel(Model model)
+template<typename T>
+void BasicGMM<T>::delModel(Model<T>& model)
 {
     model.weight.clear();
     model.mean.clear();
     model.covariance.clear();
     model.invert_covariance.clear();
     model.ExpCoeff.clear();
+    model.QuadCoeff.Clear();
 }
 
 /**
@@ -554,20 +1582,23 @@ void GMM::delModel(Model model)
  * 
  * @param model 
  */
-void GMM::completeModel(Model& model)
+template<typename T>
+void BasicGMM<T>::completeModel(Model<T>& model)
 {
     double x = pow(PI2, (-m_MfccDim / 2));
+    double coeff;
 
     for(int i = 0; i < m_MixDim; i++)
     {
-        model.ExpCoeff[i] = 1.0;
+        // Product in double, it overflows float with many features
+        coeff = 1.0;
 
         for(int j = 0; j < m_MfccDim; j++)
         {
-            model.ExpCoeff[i] *= 1.0 / model.covariance[i][j];
+            coeff *= 1.0 / model.covariance[i][j];
         }
 
-        model.ExpCoeff[i] = x * sqrt(model.ExpCoeff[i]);
+        model.ExpCoeff[i] = x * sqrt(coeff);
     }
 
     for(int i = 0; i < m_MixDim; i++)
@@ -577,4 +1608,34 @@ void GMM::completeModel(Model& model)
             model.invert_covariance[i][j] = (-0.5) / model.covariance[i][j];
         }
     }
+
+    expandModel(model);
 }
+
+/**
+ * @brief Fills QuadCoeff from the means and invert_covariance of the model
+ * 
+ * @param model (struct) Model with means and invert_covariance
+ */
+template<typename T>
+void BasicGMM<T>::expandModel(Model<T>& model)
+{
+    // inv*(x - mean)^2 = inv*x^2 - 2*inv*mean*x + inv*mean^2, the constant row is summed in double
+    for(int i = 0; i < m_MixDim; i++)
+    {
+        double constant = 0.0;
+
+        for(int j = 0; j < m_MfccDim; j++)
+        {
+            double invert = model.invert_covariance[i][j];
+
+            model.QuadCoeff[j][i] = invert;
+            model.QuadCoeff[m_MfccDim + j][i] = -2.0 * invert * model.mean[j][i];
+            constant += invert * model.mean[j][i] * model.mean[j][i];
+        }
+        model.QuadCoeff[2 * m_MfccDim][i] = constant;
+    }
+}
+
+typedef BasicGMM<double> GMM;
+typedef BasicGMM<float> GMMF;
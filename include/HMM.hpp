@@ -9,33 +9,38 @@
 #include <math.h>
 
 #include "Matrix.hpp"
+#include "FeatureMatrix.hpp"
+#include "FastMath.hpp"
 
+template<typename T>
 struct Model
 {
-    std::vector<double> weight;
-    std::vector<std::vector<double> > mean;
-    std::vector<std::vector<double> > covariance;
-    std::vector<std::vector<double> > invert_covariance;
-    std::vector<double> ExpCoeff;
+    std::vector<T> weight;
+    std::vector<std::vector<T> > mean;
+    std::vector<std::vector<T> > covariance;
+    std::vector<std::vector<T> > invert_covariance;
+    std::vector<T> ExpCoeff;
 };
 
-class HMM
+template<typename T>
+class BasicHMM
 {
 private:
     /* data */
-    Model newModel();
-    void delModel(Model model);
-    void completeModel(Model& model);
-    double Likelihood(const std::vector<std::vector<double>>& melCepData, size_t frameCount, Model model, std::vector<std::vector<double>>& normProb, std::vector<double>& mixedProb);
+    Model<T> newModel();
+    void delModel(Model<T> model);
+    void completeModel(Model<T>& model);
+    double Likelihood(const BasicFeatureView<T>& melCepData, size_t frameCount, Model<T> model, BasicFeatureMatrix<T>& normProb, std::vector<T>& mixedProb);
 
     int m_MixDim;
     int m_MfccDim;
     int num_states;
     double m_Threshold;
     double m_MinCov;
-    Model m_Model;
+    Model<T> m_Model;
     int number_gaussian_components;
-    std::map<std::string, Model> m_Models;
+    std::map<std::string, Model<T>> m_Models;
+    bool m_FastMath;
 
     const double PI2 = 6.28318530717958647692;
 
@@ -50,34 +55,37 @@ private:
 
 
 public:
-    HMM(int states, int mfcc_dim);
-    virtual ~HMM();
+    BasicHMM(int states, int mfcc_dim);
+    virtual ~BasicHMM();
 
-    std::string Classify(const std::vector<std::vector<double> > &melCepData, size_t frameCount);
-    double Likelihood(const std::vector<std::vector<double> > &melCepData, size_t frameCount);
+    std::string Classify(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    double Likelihood(const BasicFeatureView<T>& melCepData, size_t frameCount);
+    void setFastMath(bool enable);
     bool LoadModel(const std::string& filePath);
     bool SaveModel(const std::string& filePath);
     bool AddModel(const std::string& name);
     bool AddModel(const std::string& filePath, const std::string& name);
 
-    double Gaussian_Distribution(std::vector<double> data, std::vector<double> &mean, std::vector<std::vector<double> > &covariance);
-    int Expectation_Maximation(const std::vector<std::vector<double> > &melCepData, size_t frameCount);
+    double Gaussian_Distribution(const T* data, std::vector<T> &mean, std::vector<std::vector<T> > &covariance);
+    int Expectation_Maximation(const BasicFeatureView<T>& melCepData, size_t frameCount);
     double Fordward_Algorithm(int num_states, std::vector<int> &state, std::vector<std::vector<double> > &state_transition_probability, std::vector<double> &state_observation_probability, std::vector<std::vector<double> > &alpha);
 };
 
 /**
- * @brief Construct a new HMM::HMM object
+ * @brief Construct a new BasicHMM object
  * 
  * @param states    (int) Number of HMM states
  * @param mfcc_dim  (int) Dimension of MFCC Matrix
  */
-HMM::HMM(int states, int mfcc_dim) 
+template<typename T>
+BasicHMM<T>::BasicHMM(int states, int mfcc_dim) 
 {
     // Set the mfcc dimension
     // Set the mixture dimensions
     this->m_MixDim = mfcc_dim;
     this->m_MfccDim = mfcc_dim;
     this->num_states = states;
+    this->m_FastMath = FastMath::Default;
 
     // Initital Probability pi
     for(int i = 0; i < num_states; i++)
@@ -112,11 +120,12 @@ HMM::HMM(int states, int mfcc_dim)
     m_Model = newModel();
 }
 
-HMM::~HMM()
+template<typename T>
+BasicHMM<T>::~BasicHMM()
 {
     delModel(m_Model);
 
-    std::map<std::string, Model>::const_iterator it = m_Models.begin();
+    typename std::map<std::string, Model<T>>::const_iterator it = m_Models.begin();
     while(it != m_Models.end())
     {
         delModel(it->second);
@@ -140,11 +149,12 @@ HMM::~HMM()
  *        E: estimation step
  *        M: maximation step
  * 
- * @param melCepData (2d-vector) matrix contains the frames with features: melCepData(frames x 39)
+ * @param melCepData (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
  * @param frameCount (size_t) number of frames 
  * @return (int) number of training iterations
  */
-int HMM::Expectation_Maximation(const std::vector<std::vector<double> > &melCepData, size_t frameCount)
+template<typename T>
+int BasicHMM<T>::Expectation_Maximation(const BasicFeatureView<T>& melCepData, size_t frameCount)
 {
     int step;
 	int iteration = 0;
@@ -152,10 +162,10 @@ int HMM::Expectation_Maximation(const std::vector<std::vector<double> > &melCepD
 	double recentProb = 0.0;
 
     std::vector<double> sumProb(m_MixDim);
-    std::vector<double> mixedProb(frameCount);
-    std::vector<std::vector<double>> normProb(frameCount, std::vector<double>(m_MixDim));
+    std::vector<T> mixedProb(frameCount);
+    BasicFeatureMatrix<T> normProb(frameCount, m_MixDim);
     std::vector<std::vector<double>> tempProb(m_MfccDim, std::vector<double>(m_MixDim));
-    std::vector<std::vector<double>> squareCep(frameCount, std::vector<double>(m_MfccDim));
+    BasicFeatureMatrix<T> squareCep(frameCount, m_MfccDim);
 
 	//*** Initialize the Gaussian mixture Models
 	for(int i = 0; i < m_MixDim; i++)
@@ -279,7 +289,7 @@ int HMM::Expectation_Maximation(const std::vector<std::vector<double> > &melCepD
     }
 
 	tempProb.clear();
-	normProb.clear();
+	normProb.Clear();
 	sumProb.clear();
 	mixedProb.clear();
 
@@ -287,7 +297,8 @@ int HMM::Expectation_Maximation(const std::vector<std::vector<double> > &melCepD
 }
 
 
-double HMM::Fordward_Algorithm(int num_states, std::vector<int> &state, std::vector<std::vector<double> > &state_transition_probability, std::vector<double> &state_observation_probability, std::vector<std::vector<double> > &alpha)
+template<typename T>
+double BasicHMM<T>::Fordward_Algorithm(int num_states, std::vector<int> &state, std::vector<std::vector<double> > &state_transition_probability, std::vector<double> &state_observation_probability, std::vector<std::vector<double> > &alpha)
 {
     double log_likelihood = 0;
 
@@ -333,30 +344,23 @@ double HMM::Fordward_Algorithm(int num_states, std::vector<int> &state, std::vec
 /**
  * @brief Decoder of the HMM
  * 
- * @param melCepData (2d-vector) matrix contains the frames with features: melCepData(frames x 39)
+ * @param melCepData (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
  * @param frameCount (size_t) number of frames 
  * @return (string) returns the recognized name
  */
-std::string HMM::Classify(const std::vector<std::vector<double> >& melCepData, size_t frameCount)
+template<typename T>
+std::string BasicHMM<T>::Classify(const BasicFeatureView<T>& melCepData, size_t frameCount)
 {
     double likelihood;
     double probMax = 0;
     std::string name;
     bool first = true;
 
-    std::vector<double> mixedProb;
-    std::vector<std::vector<double> > normProb;
+    std::vector<T> mixedProb(frameCount);
+    BasicFeatureMatrix<T> normProb(frameCount, m_MixDim);
 
-    std::map<std::string, Model>::const_iterator it = m_Models.begin();
-    std::map<std::string, Model>::const_iterator itEnd = m_Models.end();
-
-    mixedProb.resize(frameCount);
-    normProb.resize(frameCount);
-
-    for(size_t i = 0; i < frameCount; i++)
-    {
-        normProb[i].resize(m_MixDim);
-    }
+    typename std::map<std::string, Model<T>>::const_iterator it = m_Models.begin();
+    typename std::map<std::string, Model<T>>::const_iterator itEnd = m_Models.end();
 
     while(it != itEnd)
     {
@@ -371,8 +375,7 @@ std::string HMM::Classify(const std::vector<std::vector<double> >& melCepData, s
         ++it;
     }
 
-    normProb.clear();
-	mixedProb.clear();
+    mixedProb.clear();
 
     return name;
 }
@@ -380,39 +383,43 @@ std::string HMM::Classify(const std::vector<std::vector<double> >& melCepData, s
 /**
  * @brief Calculates the Probability for each frame
  * 
- * @param melCepData (2d-vector) matrix contains the frames with features: melCepData(frames x 39)
+ * @param melCepData (FeatureView) matrix contains the frames with features: melCepData(frames x 39)
  * @param frameCount (size_t) number of frames 
  * @return (double) returns probability  
  */
-double HMM::Likelihood(const std::vector<std::vector<double> >& melCepData, size_t frameCount)
+template<typename T>
+double BasicHMM<T>::Likelihood(const BasicFeatureView<T>& melCepData, size_t frameCount)
 {
     double prob;
-    std::vector<double> mixedProb;
-    std::vector<std::vector<double> > normProb;
-
-    mixedProb.resize(frameCount);
-    normProb.resize(frameCount);
-
-    for(size_t i = 0; i<frameCount; i++)
-    {
-        normProb[i].resize(m_MixDim);
-    }
+    std::vector<T> mixedProb(frameCount);
+    BasicFeatureMatrix<T> normProb(frameCount, m_MixDim);
 
     prob = Likelihood(melCepData, frameCount, m_Model, normProb, mixedProb);
 
-    normProb.clear();
 	mixedProb.clear();
 
     return prob;
 }
 
+/**
+ * @brief Evaluates the mixtures with the polynomial exp and log of FastMath instead of libm
+ * 
+ * @param enable (bool)
+ */
+template<typename T>
+void BasicHMM<T>::setFastMath(bool enable)
+{
+    m_FastMath = enable;
+}
+
 /**
  * @brief HMM model saver to text files
  * 
  * @param filePath (string) Filepath to save location
  * @return  true if the action was successful
  */
-bool HMM::SaveModel(const std::string& filePath)
+template<typename T>
+bool BasicHMM<T>::SaveModel(const std::string& filePath)
 {
     std::ofstream outFile(filePath);
     if(!outFile.is_open())
@@ -464,7 +471,8 @@ bool HMM::SaveModel(const std::string& filePath)
  * @param filePath (string) File path to saved location
  * @return  true if the action was successful
  */
-bool HMM::LoadModel(const std::string& filePath)
+template<typename T>
+bool BasicHMM<T>::LoadModel(const std::string& filePath)
 {
     std::string title;
 
@@ -509,10 +517,11 @@ bool HMM::LoadModel(const std::string& filePath)
  * @param word (string) 
  * @return
  */
-bool HMM::AddModel(const std::string& word)
+template<typename T>
+bool BasicHMM<T>::AddModel(const std::string& word)
 {
     // Create new Model
-    Model model;
+    Model<T> model;
     model = newModel();
 
     for(int i = 0; i < m_MixDim; i++)
@@ -543,7 +552,8 @@ bool HMM::AddModel(const std::string& word)
  * @param word     (string) 
  * @return
  */
-bool HMM::AddModel(const std::string& filePath, const std::string& word)
+template<typename T>
+bool BasicHMM<T>::AddModel(const std::string& filePath, const std::string& word)
 {
     if(!LoadModel(filePath))
     {
@@ -559,18 +569,20 @@ bool HMM::AddModel(const std::string& filePath, const std::string& word)
 /**
  * @brief Computes the Likelihoof for each frame
  * 
- * @param melCepData (double)   2D Matrix of MFCC data
+ * @param melCepData (FeatureView) Matrix of MFCC data (frames x MFCCDim)
  * @param frameCount (size_t)   Number of frames
  * @param model      (struct)   Struct of HMM Models
- * @param normProb   (double)   2D Matrix of NormalPrabability
- * @param mixedProb  (double)   Vector of mixed Probability
+ * @param normProb   (FeatureMatrix) Matrix of NormalPrabability (frames x MixDim)
+ * @param mixedProb  (T)        Vector of mixed Probability
  * @return           (double)   Likelihood
  */
-double HMM::Likelihood(const std::vector<std::vector<double> > &melCepData, size_t frameCount, Model model, std::vector<std::vector<double> > &normProb, std::vector<double> &mixedProb)
+template<typename T>
+double BasicHMM<T>::Likelihood(const BasicFeatureView<T>& melCepData, size_t frameCount, Model<T> model, BasicFeatureMatrix<T>& normProb, std::vector<T>& mixedProb)
 {
 	double prob = 0.0;
-    std::vector<double> maxMatrix(frameCount);
-    std::vector<std::vector<double> > expMatrix(frameCount, std::vector<double>(m_MixDim, 0));
+    std::vector<T> maxMatrix(frameCount);
+    BasicFeatureMatrix<T> expMatrix(frameCount, m_MixDim);
+    std::vector<T> mixWeight(m_MixDim);
 
     // Calculate the Expectation Matrix
     for(size_t i = 0; i < frameCount; i++ )
@@ -579,20 +591,39 @@ double HMM::Likelihood(const std::vector<std::vector<double> > &melCepData, size
         {
             for(int k = 0; k < m_MfccDim; k++)
             {
-                expMatrix[i][j] += (pow((melCepData[i][k] - model.mean[k][j]),2 )) * model.invert_covariance[j][k];
+                T diff = melCepData[i][k] - model.mean[k][j];
+                expMatrix[i][j] += diff * diff * model.invert_covariance[j][k];
             }
         }
     }
 
-    for(size_t i = 0; i < frameCount; i++)
+    for(size_t i = 0; i < frameCount && !m_FastMath; i++)
     {
-        auto it = max_element(expMatrix[i].begin(), expMatrix[i].end());
+        auto it = std::max_element(expMatrix[i], expMatrix[i] + m_MixDim);
         maxMatrix[i] = *it;
     }
 
-    // calculate Probability for each frame and expectaion matrix 
+    // Weights of the log-sum-exp, the mixture weight with the gaussian normalisation
+    for(int j = 0; j < m_MixDim && m_FastMath; j++)
+    {
+        mixWeight[j] = model.ExpCoeff[j] * model.weight[j];
+    }
+
+    // All frames at once, maxMatrix receives the log-likelihoods
+    if(m_FastMath)
+        FastMath::LogSumExp(expMatrix[0], expMatrix.GetStride(), frameCount, mixWeight.data(), m_MixDim, mixedProb.data(), maxMatrix.data());
+
+    // calculate Probability for each frame and expectaion matrix, the log-likelihood is summed in double
     for(size_t i = 0; i < frameCount; i++)
     {
+        if(m_FastMath)
+        {
+            prob += maxMatrix[i];
+            for(int j = 0; j < m_MixDim; j++)
+                normProb[i][j] = expMatrix[i][j] * model.ExpCoeff[j];
+            continue;
+        }
+
         mixedProb[i] = 0.0;
         for(int j = 0; j < m_MixDim; j++)
         {
@@ -600,10 +631,9 @@ double HMM::Likelihood(const std::vector<std::vector<double> > &melCepData, size
             normProb[i][j] = expMatrix[i][j] * model.ExpCoeff[j];
             mixedProb[i] = mixedProb[i] + normProb[i][j] * model.weight[j];
         }
-        prob += log(mixedProb[i]) + maxMatrix[i];
+        prob += log((double)mixedProb[i]) + maxMatrix[i];
     }
 
-	expMatrix.clear();
 	maxMatrix.clear();
 
     return prob;
@@ -614,9 +644,10 @@ double HMM::Likelihood(const std::vector<std::vector<double> > &melCepData, size
  * 
  * @return New HMM model with initial parameters
  */
-Model HMM::newModel()
+template<typename T>
+Model<T> BasicHMM<T>::newModel()
 {
-    Model model;
+    Model<T> model;
 
     model.weight.resize(m_MixDim);
     model.mean.resize(m_MfccDim);
@@ -646,7 +677,8 @@ Model HMM::newModel()
  * 
  * @param model (struct) struct of models
  */
-void HMM::delModel(Model model)
+template<typename T>
+void BasicHMM<T>::delModel(Model<T> model)
 {
     model.weight.clear();
     model.mean.clear();
@@ -660,20 +692,23 @@ void HMM::delModel(Model model)
  * 
  * @param model 
  */
-void HMM::completeModel(Model& model)
+template<typename T>
+void BasicHMM<T>::completeModel(Model<T>& model)
 {
     double x = pow(PI2, (-m_MfccDim / 2));
+    double coeff;
 
     for(int i = 0; i < m_MixDim; i++)
     {
-        model.ExpCoeff[i] = 1.0;
+        // Product in double, it overflows float with many features
+        coeff = 1.0;
 
         for(int j = 0; j < m_MfccDim; j++)
         {
-            model.ExpCoeff[i] *= 1.0 / model.covariance[i][j];
+            coeff *= 1.0 / model.covariance[i][j];
         }
 
-        model.ExpCoeff[i] = x * sqrt(model.ExpCoeff[i]);
+        model.ExpCoeff[i] = x * sqrt(coeff);
     }
 
     for(int i = 0; i < m_MixDim; i++)
@@ -689,44 +724,45 @@ void HMM::completeModel(Model& model)
 /**
  * @brief Computes the gaussian distrubution for the state observation
  * 
- * @param data          (double)    Vector of data
- * @param mean          (double)    Vector of means
- * @param covariance    (double) Matrix of covariances
+ * @param data          (T)    Feature vector of one frame (MFCCDim)
+ * @param mean          (T)    Vector of means
+ * @param covariance    (T)    Matrix of covariances
  * @return  Observationprobability
  */
-double HMM::Gaussian_Distribution(std::vector<double> data, std::vector<double> &mean, std::vector<std::vector<double> > &covariance)
+template<typename T>
+double BasicHMM<T>::Gaussian_Distribution(const T* data, std::vector<T> &mean, std::vector<std::vector<T> > &covariance)
 {
     double result;
 	double sum = 0;
 
-	std::vector<std::vector<double> >inversed_covariance;
+	std::vector<std::vector<T> >inversed_covariance;
 
 	Matrix matrix;
 
-    inversed_covariance.resize(data.size());
-	for (int i = 0; i < data.size(); i++){
-		inversed_covariance[i].resize(data.size());
+    inversed_covariance.resize(m_MfccDim);
+	for (int i = 0; i < m_MfccDim; i++){
+		inversed_covariance[i].resize(m_MfccDim);
 	}
-	matrix.Inverse("diogonal", data.size(), covariance, inversed_covariance);
+	matrix.Inverse("diogonal", m_MfccDim, covariance, inversed_covariance);
 
-	for (int i = 0; i < data.size(); i++){
+	for (int i = 0; i < m_MfccDim; i++){
 		double partial_sum = 0;
 
-		for (int j = 0; j < data.size(); j++){
+		for (int j = 0; j < m_MfccDim; j++){
 			partial_sum += (data[j] - mean[j]) * inversed_covariance[j][i];
 		}
 		sum += partial_sum * (data[i] - mean[i]);
 	}
 
-	for (int i = 0; i < data.size(); i++){
+	for (int i = 0; i < m_MfccDim; i++){
 		inversed_covariance[i].clear();
 	}
 	inversed_covariance.clear();
 
-	result = 1.0 / (pow(2 * 3.1415926535897931, data.size() / 2.0) * sqrt(matrix.Determinant("diagonal", data.size(), covariance))) * exp(-0.5 * sum);
+	result = 1.0 / (pow(2 * 3.1415926535897931, m_MfccDim / 2.0) * sqrt(matrix.Determinant("diagonal", m_MfccDim, covariance))) * exp(-0.5 * sum);
 
 	return result;
 }
 
-
-
+typedef BasicHMM<double> HMM;
+typedef BasicHMM<float> HMMF;
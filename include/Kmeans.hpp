@@ -1,6 +1,9 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <random>
+#include <math.h>
 
 class Kmeans
 {
@@ -18,9 +21,10 @@ public:
     Kmeans(int num_features, int k);
     ~Kmeans();
 
-    void Initialize(int k_cluster, std::vector< std::vector<double> > data);
-    int Classify(std::vector<double> &data);
-    double Cluster(int number_data, std::vector< std::vector<double> > data);
+    void Initialize(int k_cluster, const std::vector< std::vector<double> >& data);
+    void InitializePlusPlus(int number_data, const std::vector< std::vector<double> >& data, unsigned int seed = 1);
+    int Classify(const std::vector<double> &data);
+    double Cluster(int number_data, const std::vector< std::vector<double> >& data);
 };
 
 /**
@@ -52,7 +56,7 @@ Kmeans::~Kmeans()
  * @param number_data   N number of data
  * @param data          N x M shaped Matrix of data
  */
-void Kmeans::Initialize(int number_data, std::vector<std::vector<double> > data)
+void Kmeans::Initialize(int number_data, const std::vector<std::vector<double> >& data)
 {
     // Divide data into cluster bins
     int number_sample = number_data / number_clusters;
@@ -73,13 +77,58 @@ void Kmeans::Initialize(int number_data, std::vector<std::vector<double> > data)
 	}
 }
 
+/**
+ * @brief Initialize Kmeans Cluster with k-means++ picks, for data sorted in groups
+ *        The first centroid is a random data point, every next one is a data point drawn with
+ *        a probability proportional to its squared distance to the nearest centroid so far.
+ *        The same seed gives the same centroids.
+ * 
+ * @param number_data   N number of data, at least k
+ * @param data          N x M shaped Matrix of data
+ * @param seed          Seed of the picks
+ */
+void Kmeans::InitializePlusPlus(int number_data, const std::vector<std::vector<double> >& data, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::vector<double> nearest(number_data, HUGE_VAL);
+    int pick = std::uniform_int_distribution<int>(0, number_data - 1)(random);
+
+    for(int i = 0; i < number_clusters; i++)
+    {
+        double total = 0;
+
+        centroid[i] = data[pick];
+
+        // Squared distance of every data point to its nearest centroid
+        for(int n = 0; n < number_data; n++)
+        {
+            double distance = 0;
+
+            for(int k = 0; k < dimension_data; k++)
+            {
+                distance += (data[n][k] - centroid[i][k]) * (data[n][k] - centroid[i][k]);
+            }
+            nearest[n] = std::min(nearest[n], distance);
+            total += nearest[n];
+        }
+
+        // Next pick, the points already taken have a distance of 0
+        double target = std::uniform_real_distribution<double>(0, total)(random);
+        for(pick = 0; pick < number_data - 1; pick++)
+        {
+            target -= nearest[pick];
+            if(target < 0) break;
+        }
+    }
+}
+
 /**
  * @brief Label the data for kmean calculation 
  * 
  * @param data N shapes data vector
  * @return     returns label 
  */
-int Kmeans::Classify(std::vector<double> &data)
+int Kmeans::Classify(const std::vector<double> &data)
 {
     int argmin;
 
@@ -112,7 +161,7 @@ int Kmeans::Classify(std::vector<double> &data)
  * @param data          N x M shaped Matrix of data
  * @return              centroid movement
  */
-double Kmeans::Cluster(int number_data, std::vector< std::vector<double> > data)
+double Kmeans::Cluster(int number_data, const std::vector< std::vector<double> >& data)
 {
     double movements_centroids = 0;
 
@@ -147,9 +196,12 @@ double Kmeans::Cluster(int number_data, std::vector< std::vector<double> > data)
 				number_sample++;
 			}
 		}
+        // A centroid without data stays where it is
+        if(number_sample == 0) continue;
+
 		for(int k = 0; k < dimension_data; k++)
         {
-			if(number_sample) mean[k] /= number_sample;
+			mean[k] /= number_sample;
 
 			movements += (centroid[j][k] - mean[k]) * (centroid[j][k] - mean[k]);
             // set new centroid
@@ -2,46 +2,100 @@
 
 #include <vector>
 #include <string>
-#include <iomanip>
-#include <fstream>
+#include <functional>
 #include <math.h>
 
-class MFCC
+#include "MFCCEngine.hpp"
+#include "Resampler.hpp"
+#include "ThreadPool.hpp"
+#include "FeatureCache.hpp"
+
+/**
+ * @brief Tables of a BasicMFCC, computed by its setters (see BasicMFCCEngine for the members)
+ * 
+ */
+template<typename T>
+struct MFCCTables
+{
+    int frameSize;
+    int frameShift;
+    int fftSize;
+    int binCount;
+    int filters;
+    int dims;
+
+    std::vector<double> window;
+    std::vector<int> filterStart;
+    std::vector<int> filterLength;
+    std::vector<int> filterOffset;
+    std::vector<double> weights;
+    std::vector<double> filterNorm;
+    double meanLogArea;
+    std::vector<T> dct;
+};
+
+/**
+ * @brief MFCC front end, the features are stored as T (double or float),
+ *        FFT and filterbank are computed in double
+ *        The configuration is chosen at run time, the analysis is the one of BasicMFCCEngine.
+ *
+ */
+template<typename T>
+class BasicMFCC : public BasicMFCCEngine<T, MFCCTables<T>>
 {
 private:
+    typedef BasicMFCCEngine<T, MFCCTables<T>> Engine;
+
+    using Engine::m_Tables;
+    using Engine::m_DeltaWindow;
+    using Engine::m_DeltaOrder;
+    using Engine::m_FrameCount;
+    using Engine::m_Filter;
+    using Engine::m_FFT;
+    using Engine::m_FastMath;
+    using Engine::m_MFCCData;
+    using Engine::m_DoneFrame;
+    using Engine::m_EmitFrame;
+    using Engine::m_CurrentFrame;
+    using Engine::m_RowOffset;
+    using Engine::m_Streaming;
+    using Engine::m_VAD;
+    using Engine::m_VADMargin;
+    using Engine::m_VADFlatness;
+    using Engine::m_VADHangover;
+    using Engine::m_SpeechFlags;
+    using Engine::setBuffers;
+    using Engine::countFrames;
+    using Engine::feed;
+
     /* data */
 
-    void fft(std::vector<double>& data, int nn, int isign);
     void setFilterBank();
     void setDCTCoeff();
     void setLiftCoeff();
-    void Analyse(std::vector<std::vector<double>>& postData, size_t frameCount, size_t currrentFrame);
+    bool feedResampled(size_t converted);
 
     double freq2mel(double freq);
     double mel2freq(double mel);
 
     //Settings
     int m_Frequence;
-    int m_FrameSize;
-    int m_FrameShift;
-    int m_FilterNumber;
-    int m_MFCCDim;
 
     //Internal
-    size_t m_FrameCount;
-    std::vector<double> m_WindowCoefs;
-    std::vector<std::vector<double>> m_FilterBank;
-    std::vector<std::vector<double>> m_DCTCoeff;
+    Resampler m_Resampler;
+    std::vector<short int> m_ResampleBuffer;
+    // Stream: converted samples still to drop for the group delay, input samples left and the filter tail
+    size_t m_ResampleSkip;
+    size_t m_ResampleLeft;
+    bool m_ResampleTail;
     std::vector<double> m_CepLifter;
-    std::vector<std::vector<double>> m_MFCCData;
 
-    size_t m_CurrentFrame;
-    std::vector<short int> m_RestData;
+    FeatureCache* m_FeatureCache;
 
     //Constantes
-    static const double PI;
-    static const double PI2;
-    static const double PI4;
+    static constexpr double PI  = 3.14159265358979323846;
+    static constexpr double PI2 = 2*PI;
+    static constexpr double PI4 = 4*PI;
 public:
     enum WindowMethod
     {
@@ -50,31 +104,45 @@ public:
         Blackman, 
         None
     };
-    MFCC();
-    MFCC(int freq, int size, int shift, WindowMethod method, int filterNum, int MFCCcDim);
-    virtual ~MFCC();
+    enum FFTMethod
+    {
+        AutoSelect,
+        MixedRadix,
+        ZeroPad
+    };
+
+    BasicMFCC();
+    BasicMFCC(int freq, int size, int shift, WindowMethod method, int filterNum, int MFCCcDim, FFTMethod fftMethod = AutoSelect);
+    virtual ~BasicMFCC();
 
     size_t Analyse(const short int data[], size_t sizeData);
-    bool Save(const std::string& filePath);
-    const std::vector<std::vector<double>>& GetMFCCData();
+    std::vector<BasicFeatureMatrix<T>> AnalyseBatch(const std::vector<std::vector<short int>>& inputs, ThreadPool& pool, std::vector<std::vector<unsigned char>>* speechFlags = nullptr);
 
     void setWindowMethod(WindowMethod method);
-    void StartAnalyse(size_t maxSize);
+    void setFFTMethod(FFTMethod method);
+    void setFeatureCache(FeatureCache* cache);
+    void setInputRate(int rate);
+    int GetInputRate();
+    uint64_t GetConfigHash();
+    void StartAnalyse(size_t maxSize = 0);
     bool AddBuffer(const short int data[], size_t sizeData);
-    size_t GetFrameCount();
+    size_t EndAnalyse();
 
+    // Samples converted per step by AddBuffer when the input rate differs
+    static constexpr size_t ResampleChunk = 4096;
 };
 
 /**
- * @brief Construct a new MFCC::MFCC object
+ * @brief Construct a new BasicMFCC object
  * 
  */
-MFCC::MFCC() : MFCC(16000, 16, 8, WindowMethod::Hamming, 24, 12)
+template<typename T>
+BasicMFCC<T>::BasicMFCC() : BasicMFCC(16000, 16, 8, WindowMethod::Hamming, 24, 12)
 {
 }
 
 /**
- * @brief Construct a new MFCC::MFCC object
+ * @brief Construct a new BasicMFCC object
  * 
  * @param freq      (int)   Frequency of the Signal
  * @param size      (int)   Frame length, default is 0.025
@@ -82,324 +150,316 @@ MFCC::MFCC() : MFCC(16000, 16, 8, WindowMethod::Hamming, 24, 12)
  * @param method    (enum)  Window type: Hamming, Hann, Blackman, None
  * @param filterNum (int)   Number of filters for the Mel-filterbank
  * @param MFCCDim   (int)   Dimension of the MFCC matrix
+ * @param fftMethod (enum)  FFT plan: AutoSelect, MixedRadix, ZeroPad
  */
-MFCC::MFCC(int freq, int size, int shift, WindowMethod method, int filterNum, int MFCCDim)
+template<typename T>
+BasicMFCC<T>::BasicMFCC(int freq, int size, int shift, WindowMethod method, int filterNum, int MFCCDim, FFTMethod fftMethod)
 {
     m_Frequence = freq;
-    m_FrameSize = freq*size/1000;
-    m_FrameShift= freq*shift/1000;
-    m_FilterNumber=filterNum;
-    m_MFCCDim   = MFCCDim;
+    m_Tables.frameSize = freq*size/1000;
+    m_Tables.frameShift= freq*shift/1000;
+    m_Tables.filters   = filterNum;
+    m_Tables.dims      = MFCCDim;
 
-    m_FrameCount  = 0;
-    m_CurrentFrame= 0;
+    m_FeatureCache= nullptr;
+    m_ResampleSkip= 0;
+    m_ResampleLeft= 0;
+    m_ResampleTail= false;
 
+    setFFTMethod(fftMethod);
     setWindowMethod(method);
-    setFilterBank();
-    setDCTCoeff();
     setLiftCoeff();
+    setDCTCoeff();
 }
 
 /**
- * @brief Destroy the MFCC::MFCC object
+ * @brief Destroy the BasicMFCC object
  * 
  */
-MFCC::~MFCC()
+template<typename T>
+BasicMFCC<T>::~BasicMFCC()
 {
-    m_WindowCoefs.clear();
-    m_FilterBank.clear();
-    m_DCTCoeff.clear();
+    m_ResampleBuffer.clear();
     m_CepLifter.clear();
-    m_MFCCData.clear();
-    m_RestData.clear();
 }
 
 /**
- * @brief 
+ * @brief Analyses a whole signal, from the feature cache when it was analysed before
  * 
- * @param data      (short int) data vector
+ * @param data      (short int) data vector, at the input rate (see setInputRate)
  * @param sizeData  (size_t)    Lenght of data vector
  * @return          Frame count of MFCC data
  */
-size_t MFCC::Analyse(const short int data[], size_t sizeData)
+template<typename T>
+size_t BasicMFCC<T>::Analyse(const short int data[], size_t sizeData)
 {
-    std::vector<std::vector<double> > postData;
+    size_t frameCount, delay;
+    uint64_t key = 0;
 
-    ///*** Initialisation
-    m_MFCCData.clear();
-    m_CurrentFrame = 0;
-    m_FrameCount = (sizeData - m_FrameSize + m_FrameShift) / m_FrameShift;
-    m_MFCCData.resize(m_FrameCount);
-    postData.resize(m_FrameCount);
+    ///*** Other input rate: the whole signal is converted first, the rest sees the samples at m_Frequence
+    ///    The group delay of the filter is dropped and its tail flushed, the frames stay on the input
+    if(m_Resampler.IsActive())
+    {
+        m_Resampler.Reset();
+        m_ResampleBuffer.resize(m_Resampler.GetOutputSize(sizeData) + m_Resampler.GetDelay());
+        sizeData = m_Resampler.Process(data, sizeData, m_ResampleBuffer.data());
+        sizeData += m_Resampler.Flush(&m_ResampleBuffer[sizeData]);
+        delay = std::min(sizeData, m_Resampler.GetDelay());
+        data = &m_ResampleBuffer[delay];
+        sizeData -= delay;
+    }
 
-    ///*** Apply the window coefficients
-    for(size_t i = 0; i < m_FrameCount; i++)
+    ///*** Same samples and settings analysed before
+    if(m_FeatureCache != nullptr)
     {
-        for(int j = 0; j < m_FrameSize; j++)
+        frameCount = countFrames(sizeData);
+        m_Streaming = false;
+        key = FeatureCache::Hash(data, sizeData * sizeof(short int), GetConfigHash());
+        if(m_FeatureCache->Load(key, this->GetFeatureDim(), m_MFCCData, m_VAD ? &m_SpeechFlags : nullptr) && m_MFCCData.GetRows() == frameCount && m_MFCCData.GetCols() == (size_t)this->GetFeatureDim())
         {
-            // Appply Hamming window to function
-            postData[i].push_back(data[i * m_FrameShift + j] * m_WindowCoefs[j]);
-            postData[i].push_back(0);
+            m_FrameCount = frameCount;
+            m_CurrentFrame = m_EmitFrame = m_DoneFrame = frameCount;
+            m_RowOffset = 0;
+            if(!m_VAD) m_SpeechFlags.clear();
+            return m_FrameCount;
         }
     }
 
-    ///*** Analyse (FFT, E, Filterbank)
-    Analyse(postData, m_FrameCount, 0);
-    postData.clear();
+    frameCount = Engine::Analyse(data, sizeData);
+
+    if(m_FeatureCache != nullptr && frameCount > 0)
+        m_FeatureCache->Store(key, m_MFCCData, m_VAD ? &m_SpeechFlags : nullptr);
 
-    return m_FrameCount;
+    return frameCount;
 }
 
 /**
- * @brief 
+ * @brief Analyses many signals on the workers of pool, each worker uses its own copy of this MFCC
  * 
- * @param postData       (double)   Data vector
- * @param frameCount     (size_t)   Number of MFCC frames 
- * @param currrentFrame  (size_t)   Number of current MFCC frames
+ * @param inputs      (vector)     Signals (short int samples)
+ * @param pool        (ThreadPool) Workers
+ * @param speechFlags (vector)     Receives the speech tags of every signal (see setVAD), nullptr if not needed
+ * @return            (vector)     MFCC matrix of every signal (frames x FeatureDim), in the order of inputs
  */
-void MFCC::Analyse(std::vector<std::vector<double> >& postData, size_t frameCount, size_t currrentFrame)
+template<typename T>
+std::vector<BasicFeatureMatrix<T>> BasicMFCC<T>::AnalyseBatch(const std::vector<std::vector<short int>>& inputs, ThreadPool& pool, std::vector<std::vector<unsigned char>>* speechFlags)
 {
-    std::vector<std::vector<double>> spectralPower;
-    std::vector<std::vector<double>> melSpectralPower;
+    std::vector<BasicFeatureMatrix<T>> results(inputs.size());
+    std::vector<BasicMFCC<T>> workers(pool.GetWorkerCount(), *this);
 
+    if(speechFlags != nullptr)
+        speechFlags->assign(inputs.size(), std::vector<unsigned char>());
 
-    ///*** FFT matrix
-    for(size_t i = 0; i < frameCount; i++)
+    pool.ParallelFor(inputs.size(), [&](size_t i, int worker)
     {
-        fft(postData[i], m_FrameSize, 1);
-    }
+        workers[worker].Analyse(inputs[i].data(), inputs[i].size());
+        results[i] = std::move(workers[worker].m_MFCCData);
+        if(speechFlags != nullptr)
+            (*speechFlags)[i] = workers[worker].m_SpeechFlags;
+    });
 
-    ///*** Energy matrix
-    spectralPower.resize(frameCount);
+    return results;
+}
 
-    for(size_t i = 0; i < frameCount; i++)
+/**
+ * @brief Starts the analyse of a stream given in buffers of any size by AddBuffer
+ *        With maxSize the stream stops after maxSize samples and GetMFCCData holds all frames.
+ *        Without, the stream is unbounded: only the last block of frames is kept in
+ *        GetMFCCData and the frames are passed on by the frame callback.
+ *        The buffers are allocated here, AddBuffer does not allocate memory.
+ * 
+ * @param maxSize (size_t) Maximum number of samples at the input rate, 0 for an unbounded stream
+ */
+template<typename T>
+void BasicMFCC<T>::StartAnalyse(size_t maxSize)
+{
+    m_Resampler.Reset();
+    m_ResampleSkip = m_Resampler.GetDelay();
+    m_ResampleLeft = maxSize;
+    m_ResampleTail = m_Resampler.IsActive();
+    if(m_Resampler.IsActive())
     {
-        for(int j = 0; j < m_FrameSize / 2+1; j++)
-        {
-            spectralPower[i].push_back(postData[i][j<<1] * postData[i][j<<1] + postData[i][(j<<1) + 1] * postData[i][(j<<1) +1 ]);
-        }
+        m_ResampleBuffer.resize(std::max(ResampleChunk, m_Resampler.GetDelay()));
+        maxSize = m_Resampler.GetOutputSize(maxSize);
     }
 
+    Engine::StartAnalyse(maxSize);
+}
 
+/**
+ * @brief Analyses the next samples of the stream started by StartAnalyse
+ *        The samples not used by a complete frame are kept for the next call.
+ * 
+ * @param data      (short int) data vector, at the input rate (see setInputRate)
+ * @param sizeData  (size_t)    Lenght of data vector
+ * @return          (bool) False when the stream is not started or the maximum size is reached
+ */
+template<typename T>
+bool BasicMFCC<T>::AddBuffer(const short int data[], size_t sizeData)
+{
+    size_t count, converted;
 
-    melSpectralPower.resize(m_FilterNumber);
-
-    ///*** Apply filter bank
-    for(int i = 0; i < m_FilterNumber; i++)
-    {
-        for(size_t k = 0; k < frameCount; k++)
-        {
-            melSpectralPower[i].push_back(0);
-            for(int j = 0; j < m_FrameSize / 2+1; j++)
-            {
-                melSpectralPower[i][k] += m_FilterBank[i][j] * spectralPower[k][j];
-            }
-
-            melSpectralPower[i][k] = log(melSpectralPower[i][k]);
-        }
-    }
-
-    spectralPower.clear();
+    if(!m_Streaming) return false;
+    if(!m_Resampler.IsActive()) return feed(data, sizeData);
 
-    ///*** MFCCc matrix
-    for(size_t k = 0; k < frameCount; k++)
+    ///*** Converted in pieces which fit the buffer of StartAnalyse
+    for(size_t done = 0; done < sizeData; done += count)
     {
-        //MFCC + e
-        for(int i = 0; i < (m_MFCCDim); i++)
-        {
-            m_MFCCData[currrentFrame+k].push_back(0);
-            for(int j = 0; j < m_FilterNumber; j++)
-            {
-                m_MFCCData[currrentFrame+k][i] += m_DCTCoeff[i][j] * melSpectralPower[j][k];
-            }
-        }
+        count = std::min(sizeData - done, std::max((size_t)1, ResampleChunk * m_Resampler.GetInputRate() / m_Resampler.GetOutputRate()));
+        converted = m_Resampler.Process(&data[done], count, m_ResampleBuffer.data());
+        if(!feedResampled(converted))
+            return false;
     }
 
-    melSpectralPower.clear();
-
-    ///*** Ceplift
-    for(size_t i = 0; i < frameCount; i++)
+    ///*** A bounded stream ends with its last input sample, the tail of the filter follows
+    if(m_ResampleLeft > 0)
     {
-        for(int j = 0; j < m_MFCCDim; j++)
+        m_ResampleLeft -= std::min(m_ResampleLeft, sizeData);
+        if(m_ResampleLeft == 0 && m_ResampleTail)
         {
-            m_MFCCData[currrentFrame+i][j] *= m_CepLifter[j];
+            m_ResampleTail = false;
+            return feedResampled(m_Resampler.Flush(m_ResampleBuffer.data()));
         }
     }
-
-    return;
+    return true;
 }
 
 /**
- * @brief Saves the MFCC extracted data to file
+ * @brief Feeds the converted samples in m_ResampleBuffer, the first GetDelay of the stream are dropped
+ *        so the frames start with the first input sample, like Analyse
  * 
- * @param filePath (string) Path where the MFCC get saved
- * @return         (bool) If operation was successful
+ * @param converted (size_t) Number of samples in m_ResampleBuffer
+ * @return          (bool) False when the maximum size is reached
  */
-bool MFCC::Save(const std::string& filePath)
+template<typename T>
+bool BasicMFCC<T>::feedResampled(size_t converted)
 {
-	size_t frameCount;
-    std::ofstream outFile(filePath);
-
-    if(!outFile.is_open())
-        return false;
+    size_t skip = std::min(converted, m_ResampleSkip);
 
-    outFile << std::fixed << std::setprecision(6);
+    m_ResampleSkip -= skip;
+    return feed(&m_ResampleBuffer[skip], converted - skip);
+}
 
-    if(m_CurrentFrame > 0 )
-        frameCount = m_CurrentFrame;
-    else
-        frameCount = m_FrameCount;
+/**
+ * @brief Ends the stream, the last frames waiting for the look-ahead of the deltas are completed
+ *        with the last frame repeated
+ * 
+ * @return (size_t) Number of frames of the stream
+ */
+template<typename T>
+size_t BasicMFCC<T>::EndAnalyse()
+{
+    if(!m_Streaming) return m_DoneFrame;
 
-    for(size_t i=0; i<frameCount; i++)
+    // Last samples still in the filter of the input rate
+    if(m_ResampleTail)
     {
-        for(int j=0; j<m_MFCCDim; j++)
-            outFile << m_MFCCData[i][j] << " ";
-        outFile << std::endl;
+        m_ResampleTail = false;
+        feedResampled(m_Resampler.Flush(m_ResampleBuffer.data()));
     }
 
-    outFile.close();
-    return true;
+    return Engine::EndAnalyse();
 }
 
 /**
- * @brief Returns the MFCC data vector
+ * @brief Lets Analyse load the features from cache and store new ones there
+ *        The cache has to be usable from all threads running AnalyseBatch.
  * 
- * @return 2 D Vector with MFCC data
+ * @param cache (FeatureCache) nullptr to disable
  */
-const std::vector<std::vector<double> >& MFCC::GetMFCCData()
+template<typename T>
+void BasicMFCC<T>::setFeatureCache(FeatureCache* cache)
 {
-    return m_MFCCData;
+    m_FeatureCache = cache;
 }
 
-void MFCC::StartAnalyse(size_t maxSize)
+/**
+ * @brief Sets the sample rate of the signals given to Analyse and AddBuffer (default: the frequency
+ *        of the constructor). Another rate is converted by a polyphase FIR (see Resampler), so
+ *        e.g. 48000 Hz input runs through the cheaper 16000 Hz front end. The filterbank spreads
+ *        up to m_Frequence/2, so the default passband of the Resampler (Rolloff of that band) is
+ *        kept free of aliasing. The group delay of the filter (GetDelay) is dropped and its tail
+ *        flushed at the end of the signal, so the frames start on the same input samples as at
+ *        the native rate.
+ *        Takes effect with the next Analyse or StartAnalyse.
+ * 
+ * @param rate (int) Samples per second
+ */
+template<typename T>
+void BasicMFCC<T>::setInputRate(int rate)
 {
-    m_CurrentFrame = 0;
-    m_FrameCount = (maxSize-m_FrameSize+m_FrameShift)/m_FrameShift;
-    m_MFCCData.clear();
-    m_MFCCData.resize(m_FrameCount);
-
-    m_RestData.clear();
+    if(rate != m_Resampler.GetInputRate() || m_Frequence != m_Resampler.GetOutputRate())
+        m_Resampler = Resampler(rate, m_Frequence);
 }
 
-bool MFCC::AddBuffer(const short int data[], size_t sizeData)
+template<typename T>
+int BasicMFCC<T>::GetInputRate()
 {
-    std::vector<std::vector<double> > postData;
-    size_t restSize = m_RestData.size();
-    size_t frameCount;
-	size_t i, k;
-    int j;
-
-
-    ///*** Initialisation
-    if(m_FrameCount==0) return false;
-    frameCount = (sizeData+restSize-m_FrameSize+m_FrameShift)/m_FrameShift;
-    if(m_CurrentFrame+frameCount>m_FrameCount)
-    {
-        frameCount = m_FrameCount-m_CurrentFrame;
-        if(frameCount == 0) return false;
-    }
-    postData.resize(frameCount);
-
-    ///*** Apply the window coefficients
-    for(i = 0; i < frameCount; i++)
-    {
-        for(j=0; j<m_FrameSize; j++)
-        {
-            k = i*m_FrameShift+j;
-            if(k<restSize)
-                postData[i].push_back(m_RestData[k]*m_WindowCoefs[j]);
-            else
-                postData[i].push_back(data[i*m_FrameShift+j-restSize]*m_WindowCoefs[j]);
-
-            postData[i].push_back(0);
-        }
-    }
-    m_RestData.clear();
-
-    ///*** Analyse
-    Analyse(postData, frameCount, m_CurrentFrame);
-    postData.clear();
-    m_CurrentFrame += frameCount;
-    if(m_CurrentFrame>=m_FrameCount) return false;
+    return m_Resampler.IsActive() ? m_Resampler.GetInputRate() : m_Frequence;
+}
 
-    ///*** Memorize the remainder
-    restSize = (sizeData+restSize)-frameCount*m_FrameShift;
-    if(restSize>0)
+/**
+ * @brief Returns a hash of all settings which change the features
+ * 
+ * @return (uint64_t) Seed for the key of the feature cache
+ */
+template<typename T>
+uint64_t BasicMFCC<T>::GetConfigHash()
+{
+    int settings[] = {m_Frequence, m_Tables.frameSize, m_Tables.frameShift, m_Tables.filters, m_Tables.dims, m_Tables.fftSize, m_DeltaOrder, m_DeltaWindow, (int)sizeof(T), (int)m_FastMath};
+    double conditioning[] = {m_Filter.GetEmphasis(), m_Filter.GetDCPole()};
+    uint64_t hash;
+
+    hash = FeatureCache::Hash(settings, sizeof(settings));
+    hash = FeatureCache::Hash(conditioning, sizeof(conditioning), hash);
+    hash = FeatureCache::Hash(m_Tables.window.data(), m_Tables.window.size() * sizeof(double), hash);
+    if(m_VAD)
     {
-        for(i=sizeData-restSize; i<sizeData; i++)
-            m_RestData.push_back(data[i]);
+        // The speech tags are cached with the features
+        double vad[] = {m_VADMargin, m_VADFlatness, (double)m_VADHangover};
+        hash = FeatureCache::Hash(vad, sizeof(vad), hash);
     }
 
-    return true;
-}
-
-size_t MFCC::GetFrameCount()
-{
-    return m_CurrentFrame;
+    return hash;
 }
 
 /**
- * @brief Computes the FFT of a dataframe 
+ * @brief Chooses the FFT plan for the frame size
+ *        MixedRadix transforms the frame itself (one zero is appended to odd frames),
+ *        ZeroPad pads the frame to the next power of 2, AutoSelect takes the cheaper one.
+ *        The filterbank is computed again for the new FFT size.
  * 
- * @param data  (double)
- * @param nn    (int)
- * @param isign (int)
+ * @param method (enum)
  */
-void MFCC::fft(std::vector<double>& data, int nn, int isign)
+template<typename T>
+void BasicMFCC<T>::setFFTMethod(FFTMethod method)
 {
-	int i,j,m,n,mmax,istep;
-	double wtemp,wr,wpr,wpi,wi,theta;
-	double tempr,tempi;
+    int mixedSize = m_Tables.frameSize + (m_Tables.frameSize % 2);
+    int paddedSize = FFT::NextPowerOfTwo(m_Tables.frameSize);
 
+    switch(method)
+    {
+        case FFTMethod::MixedRadix :
+            m_Tables.fftSize = mixedSize;
+            break;
 
-	n=nn<<1;
-	j=1;
-	for(i=1;i<n;i+=2)
-	{
-		if(j>i)
-		{
-		    std::swap(data[j-1], data[i-1]);
-			std::swap(data[j], data[i]);
-		}
-		m=nn;
+        case FFTMethod::ZeroPad :
+            m_Tables.fftSize = paddedSize;
+            break;
 
-		while(m>=2&&j>m)
-		{
-            j-=m;
-			m>>=1;
-        }
-		j+=m;
-	}
+        case FFTMethod::AutoSelect :
+            if(FFT::EstimateCost(mixedSize) <= FFT::EstimateCost(paddedSize))
+                m_Tables.fftSize = mixedSize;
+            else
+                m_Tables.fftSize = paddedSize;
+            break;
+    }
 
-	mmax=2;
-	while(n>mmax)
-	{
-		istep=mmax<<1;
-		theta=isign*(PI2/mmax);
-		wtemp=sin(0.5*theta);
-		wpr=-2.0*wtemp*wtemp;
-		wpi=sin(theta);
-		wr=1.0;
-		wi=0.0;
-		for(m=1;m<mmax;m+=2)
-		{
-			for(i=m;i<=n;i+=istep)
-			{
-			    if(i>=n) continue;      //Buffer overflow if nn is not a power of 2
-   			    j=i+mmax;
-   			    if(j>=n) continue;      //Buffer overflow if nn is not a power of 2
-			    tempr=wr*data[j-1]-wi*data[j];
-			    tempi=wr*data[j]+wi*data[j-1];
-                data[j-1]=data[i-1]-tempr;
-			    data[j]=data[i]-tempi;
-			    data[i-1]+=tempr;
-			    data[i]+=tempi;
-			}
-			wr=(wtemp=wr)*wpr-wi*wpi+wr;
-			wi=wi*wpr+wtemp*wpi+wi;
-		}
-		mmax=istep;
-	}
+    m_FFT = FFT(m_Tables.fftSize);
+    m_Tables.binCount = m_FFT.GetBinCount();
+
+    setFilterBank();
+    setBuffers();
 }
 
 /**
@@ -407,30 +467,31 @@ void MFCC::fft(std::vector<double>& data, int nn, int isign)
  * 
  * @param method (enum)
  */
-void MFCC::setWindowMethod(WindowMethod method)
+template<typename T>
+void BasicMFCC<T>::setWindowMethod(WindowMethod method)
 {
-    m_WindowCoefs.clear();
+    m_Tables.window.clear();
 
     switch(method)
     {
         case WindowMethod::Hamming :
-            for(int i=0;i<m_FrameSize;i++)
-                m_WindowCoefs.push_back(0.54-0.46*(cos(PI2*(double)i/(m_FrameSize))));
+            for(int i=0;i<m_Tables.frameSize;i++)
+                m_Tables.window.push_back(0.54-0.46*(cos(PI2*(double)i/(m_Tables.frameSize))));
             break;
 
         case WindowMethod::Hann :
-            for(int i=0;i<m_FrameSize;i++)
-                m_WindowCoefs.push_back(0.5-0.5*(cos(PI2*(double)i/(m_FrameSize-1))));
+            for(int i=0;i<m_Tables.frameSize;i++)
+                m_Tables.window.push_back(0.5-0.5*(cos(PI2*(double)i/(m_Tables.frameSize-1))));
             break;
 
         case WindowMethod::Blackman :
-            for(int i=0;i<m_FrameSize;i++)
-                m_WindowCoefs.push_back(0.42-0.5*(cos(PI2*(double(i)/(m_FrameSize-1))))+0.08*(cos(PI4*(double(i)/(m_FrameSize-1)))));
+            for(int i=0;i<m_Tables.frameSize;i++)
+                m_Tables.window.push_back(0.42-0.5*(cos(PI2*(double(i)/(m_Tables.frameSize-1))))+0.08*(cos(PI4*(double(i)/(m_Tables.frameSize-1)))));
             break;
 
         case WindowMethod::None :
-            for(int i=0;i<m_FrameSize;i++)
-                m_WindowCoefs.push_back(1);
+            for(int i=0;i<m_Tables.frameSize;i++)
+                m_Tables.window.push_back(1);
             break;
     }
 }
@@ -441,7 +502,8 @@ void MFCC::setWindowMethod(WindowMethod method)
  * @param freq (double)
  * @return     (double)
  */
-double MFCC::freq2mel(double freq)
+template<typename T>
+double BasicMFCC<T>::freq2mel(double freq)
 {
 	return 1125 * log10(1 + freq / 700);
 }
@@ -452,28 +514,40 @@ double MFCC::freq2mel(double freq)
  * @param mel (double)
  * @return    (double)
  */
-double MFCC::mel2freq(double mel)
+template<typename T>
+double BasicMFCC<T>::mel2freq(double mel)
 {
 	return (pow(10, mel / 1125) - 1) * 700;
 }
 
 /**
  * @brief Computes Filterbank
+ *        Each triangular filter is stored as its span of non-zero weights
+ *        (start bin, length, offset into the weights)
  * 
  */
-void MFCC::setFilterBank()
+template<typename T>
+void BasicMFCC<T>::setFilterBank()
 {
 	double maxMel, deltaMel;
 	double lowFreq, mediumFreq, highFreq, currentFreq;
-	int filterSize = m_FrameSize/2+1;
+	int filterSize = m_Tables.fftSize/2+1;
 
 	maxMel = freq2mel(m_Frequence/4);
-	deltaMel = maxMel / (m_FilterNumber + 1);
+	deltaMel = maxMel / (m_Tables.filters + 1);
 
-	m_FilterBank.resize(m_FilterNumber);
+	std::vector<double> filter(filterSize);
+	int first, last;
+
+	m_Tables.filterStart.clear();
+	m_Tables.filterLength.clear();
+	m_Tables.filterOffset.clear();
+	m_Tables.weights.clear();
+	m_Tables.filterNorm.clear();
+	m_Tables.meanLogArea = 0;
     lowFreq = mel2freq(0);
     mediumFreq = mel2freq(deltaMel);
-	for(int i = 0; i < m_FilterNumber; i++)
+	for(int i = 0; i < m_Tables.filters; i++)
     {
 		highFreq = mel2freq(deltaMel*(i+2));
 
@@ -482,13 +556,33 @@ void MFCC::setFilterBank()
 			currentFreq = (j*1.0 / (filterSize - 1) * (m_Frequence / 4));
 
 			if((currentFreq >= lowFreq)&&(currentFreq <= mediumFreq))
-				m_FilterBank[i].push_back(2*(currentFreq - lowFreq) / (mediumFreq - lowFreq));
+				filter[j] = 2*(currentFreq - lowFreq) / (mediumFreq - lowFreq);
 			else if((currentFreq >= mediumFreq)&&(currentFreq <= highFreq))
-				m_FilterBank[i].push_back(2*(highFreq - currentFreq) / (highFreq - mediumFreq));
+				filter[j] = 2*(highFreq - currentFreq) / (highFreq - mediumFreq);
 			else
-				m_FilterBank[i].push_back(0);
+				filter[j] = 0;
 		}
 
+		// Keep the non-zero span only
+		first = 0;
+		while(first < filterSize && filter[first] == 0) first++;
+		last = filterSize - 1;
+		while(last >= first && filter[last] == 0) last--;
+
+		m_Tables.filterStart.push_back(first < filterSize ? first : 0);
+		m_Tables.filterLength.push_back(last - first + 1 > 0 ? last - first + 1 : 0);
+		m_Tables.filterOffset.push_back((int)m_Tables.weights.size());
+		for(int j = first; j <= last; j++)
+			m_Tables.weights.push_back(filter[j]);
+
+		// Area of the filter, the VAD compares band power densities
+		double area = 0;
+		for(int j = first; j <= last; j++)
+			area += filter[j];
+		area = area > 0 ? area : 1;
+		m_Tables.filterNorm.push_back(1.0 / area);
+		m_Tables.meanLogArea += log(area) / m_Tables.filters;
+
 		lowFreq = mediumFreq;
 		mediumFreq = highFreq;
 	}
@@ -496,23 +590,30 @@ void MFCC::setFilterBank()
 
 /**
  * @brief Computes DCT Coefficients
+ *        Stored as FilterNumber x MFCCDim with the lifter already applied,
+ *        setLiftCoeff has to run first
  * 
  */
-void MFCC::setDCTCoeff()
+template<typename T>
+void BasicMFCC<T>::setDCTCoeff()
 {
-    m_DCTCoeff.resize(m_MFCCDim);
-	for(int i = 0; i < m_MFCCDim; i++)
-		for(int j = 0; j < m_FilterNumber; j++)
-			m_DCTCoeff[i].push_back(2*cos((PI*(i+1)*(2*j + 1)) / (2 * m_FilterNumber)));
+    m_Tables.dct.resize(m_Tables.filters * m_Tables.dims);
+	for(int i = 0; i < m_Tables.dims; i++)
+		for(int j = 0; j < m_Tables.filters; j++)
+			m_Tables.dct[j * m_Tables.dims + i] = 2*cos((PI*(i+1)*(2*j + 1)) / (2 * m_Tables.filters)) * m_CepLifter[i];
 }
 
 /**
  * @brief Computes Lifter Coefficients
  * 
  */
-void MFCC::setLiftCoeff()
+template<typename T>
+void BasicMFCC<T>::setLiftCoeff()
 {
-	for(int i = 0; i < m_MFCCDim; i++)
-        m_CepLifter.push_back((1.0+0.5*m_MFCCDim*sin(PI*(i+1)/(m_MFCCDim)))/((double)1.0+0.5*m_MFCCDim));
+    m_CepLifter.clear();
+	for(int i = 0; i < m_Tables.dims; i++)
+        m_CepLifter.push_back((1.0+0.5*m_Tables.dims*sin(PI*(i+1)/(m_Tables.dims)))/((double)1.0+0.5*m_Tables.dims));
 }
 
+typedef BasicMFCC<double> MFCC;
+typedef BasicMFCC<float> MFCCF;
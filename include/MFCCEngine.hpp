@@ -0,0 +1,863 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <fstream>
+#include <functional>
+#include <cstring>
+#include <math.h>
+
+#include "FFT.hpp"
+#include "FastMath.hpp"
+#include "Filter.hpp"
+#include "FeatureMatrix.hpp"
+
+/**
+ * @brief Analysis of BasicMFCC and BasicStaticMFCC: conditioning, framing, FFT, filterbank, DCT,
+ *        deltas, VAD and streaming. The configuration comes from Tables only, with the members
+ *          frameSize, frameShift, fftSize, binCount, filters, dims   (int)
+ *          window (frameSize), weights, filterStart, filterLength, filterOffset, filterNorm (filters),
+ *          meanLogArea (double), dct (filters x dims, lifter applied)
+ *        BasicMFCC fills them at run time, BasicStaticMFCC has them as constants of the program,
+ *        so every loop over the frame, the filters and the coefficients gets a constant trip count.
+ *        The FFT plan and the buffers (setBuffers) are set by the derived class.
+ * 
+ */
+template<typename T, class Tables>
+class BasicMFCCEngine
+{
+public:
+    // Receives the new frames (rows of the MFCC matrix) and the index of the first one
+    typedef std::function<void(const BasicFeatureView<T>& frames, size_t firstFrame)> FrameCallback;
+
+    // Frames analysed together, the block buffers stay in cache
+    static constexpr int BlockSize = 64;
+
+protected:
+    /* data */
+
+    void setBuffers();
+    size_t countFrames(size_t sizeData);
+    double applyFilterBank(const double power[], T melPower[]);
+    void analyseBlock(size_t frameCount, size_t currentFrame);
+    void applyDCT(size_t frameCount, size_t currentFrame);
+    void computeDeltas(size_t frameCount, bool final);
+    void emitFrames();
+    unsigned char detectSpeech(const T melPower[], double density);
+    BasicFeatureView<T> rowView(size_t row, size_t count);
+    void startStream(size_t frameCount);
+    bool feed(const short int data[], size_t sizeData);
+
+    Tables m_Tables;
+    int m_DeltaWindow;
+    int m_DeltaOrder;
+
+    //Internal
+    size_t m_FrameCount;
+    Filter m_Filter;
+    FFT m_FFT;
+    std::vector<double> m_BandPower;
+    bool m_FastMath;
+    BasicFeatureMatrix<T> m_MFCCData;
+
+    //Block buffers
+    std::vector<double> m_FrameBuffer;
+    std::vector<double> m_PowerBuffer;
+    BasicFeatureMatrix<T> m_MelBuffer;
+
+    //Deltas, frames done up to m_DeltaFrame[order-1]
+    std::vector<size_t> m_DeltaFrame;
+    size_t m_DoneFrame;
+    size_t m_EmitFrame;
+
+    //Streaming, row 0 of the MFCC matrix is frame m_RowOffset
+    size_t m_CurrentFrame;
+    size_t m_RowOffset;
+    bool m_Streaming;
+    std::vector<double> m_Ring;
+    size_t m_RingMask;
+    size_t m_RingRead;
+    size_t m_RingWrite;
+    FrameCallback m_FrameCallback;
+
+    //Voice activity detection, one tag per row of the MFCC matrix
+    bool m_VAD;
+    double m_VADMargin;
+    double m_VADFlatness;
+    int m_VADHangover;
+    double m_NoiseFloor;
+    int m_HangoverLeft;
+    std::vector<unsigned char> m_SpeechFlags;
+
+    //Constantes
+    // Rise of the noise floor per frame (log power), it follows a louder background within seconds
+    static constexpr double NoiseRise = 0.01;
+
+public:
+    BasicMFCCEngine();
+    virtual ~BasicMFCCEngine();
+
+    size_t Analyse(const short int data[], size_t sizeData);
+    bool Save(const std::string& filePath);
+    const BasicFeatureMatrix<T>& GetMFCCData();
+    BasicFeatureView<T> GetFeatures();
+    const std::vector<unsigned char>& GetSpeechFlags();
+
+    void setFrameCallback(FrameCallback callback);
+    void setDeltas(int order, int window = 2);
+    void setPreEmphasis(double coefficient);
+    void setDCRemoval(double pole);
+    void setVAD(bool enable, double margin = 2.5, double flatness = -0.6, int hangover = 10);
+    void setFastMath(bool enable);
+    void StartAnalyse(size_t maxSize = 0);
+    bool AddBuffer(const short int data[], size_t sizeData);
+    size_t EndAnalyse();
+    size_t GetFrameCount();
+    int GetFeatureDim();
+    int GetFFTSize();
+};
+
+/**
+ * @brief Construct a new BasicMFCCEngine object, without buffers
+ * 
+ */
+template<typename T, class Tables>
+BasicMFCCEngine<T, Tables>::BasicMFCCEngine()
+{
+    m_DeltaWindow = 2;
+    m_DeltaOrder  = 0;
+
+    m_FrameCount  = 0;
+    m_CurrentFrame= 0;
+    m_RowOffset   = 0;
+    m_DoneFrame   = 0;
+    m_EmitFrame   = 0;
+    m_Streaming   = false;
+    m_RingMask  = 0;
+    m_RingRead  = 0;
+    m_RingWrite = 0;
+
+    m_VAD         = false;
+    m_VADMargin   = 2.5;
+    m_VADFlatness = -0.6;
+    m_VADHangover = 10;
+    m_NoiseFloor  = 0;
+    m_HangoverLeft= 0;
+    m_FastMath    = FastMath::Default;
+}
+
+/**
+ * @brief Destroy the BasicMFCCEngine object
+ * 
+ */
+template<typename T, class Tables>
+BasicMFCCEngine<T, Tables>::~BasicMFCCEngine()
+{
+    m_BandPower.clear();
+    m_MFCCData.Clear();
+    m_SpeechFlags.clear();
+    m_Ring.clear();
+    m_FrameBuffer.clear();
+    m_PowerBuffer.clear();
+}
+
+/**
+ * @brief Sizes the block buffers for the FFT size and the filters of m_Tables
+ * 
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setBuffers()
+{
+    m_FrameBuffer.assign(BlockSize * m_Tables.fftSize, 0);
+    m_PowerBuffer.assign(FFT::BatchSize * m_Tables.binCount, 0);
+    m_MelBuffer.Resize(BlockSize, m_Tables.filters);
+    m_BandPower.assign(m_Tables.filters, 0);
+}
+
+/**
+ * @brief Returns the number of complete frames in sizeData samples
+ * 
+ * @param sizeData (size_t)
+ * @return         (size_t)
+ */
+template<typename T, class Tables>
+size_t BasicMFCCEngine<T, Tables>::countFrames(size_t sizeData)
+{
+    if(sizeData < (size_t)m_Tables.frameSize)
+        return 0;
+
+    return (sizeData - m_Tables.frameSize + m_Tables.frameShift) / m_Tables.frameShift;
+}
+
+/**
+ * @brief Analyses a whole signal
+ * 
+ * @param data      (short int) data vector
+ * @param sizeData  (size_t)    Lenght of data vector
+ * @return          Frame count of MFCC data
+ */
+template<typename T, class Tables>
+size_t BasicMFCCEngine<T, Tables>::Analyse(const short int data[], size_t sizeData)
+{
+    size_t frameCount = countFrames(sizeData);
+
+    ///*** Initialisation, a running stream is stopped
+    m_Streaming = false;
+
+    if(frameCount == 0)
+    {
+        m_MFCCData.Clear();
+        m_SpeechFlags.clear();
+        m_FrameCount = m_CurrentFrame = m_EmitFrame = m_DoneFrame = m_RowOffset = 0;
+        return 0;
+    }
+
+    ///*** The signal is analysed as a stream of known length, the frame callback is not used
+    startStream(frameCount);
+    m_Streaming = false;
+    feed(data, sizeData);
+
+    return m_FrameCount;
+}
+
+/**
+ * @brief Analyses one block of windowed frames
+ * 
+ * @param frameCount    (size_t)   Number of frames in m_FrameBuffer, at most BlockSize
+ * @param currentFrame  (size_t)   Row of the first frame in the MFCC matrix
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::analyseBlock(size_t frameCount, size_t currentFrame)
+{
+    double density;
+
+    ///*** FFT, energy and filter bank, one SIMD batch of frames at a time
+    ///    so the power spectra are still in cache when the filters are applied
+    for(size_t b = 0; b < frameCount; b += FFT::BatchSize)
+    {
+        size_t count = std::min(frameCount - b, (size_t)FFT::BatchSize);
+
+        m_FFT.PowerSpectrum(&m_FrameBuffer[b * m_Tables.fftSize], m_Tables.fftSize, m_PowerBuffer.data(), m_Tables.binCount, count);
+
+        for(size_t k = 0; k < count; k++)
+        {
+            density = applyFilterBank(&m_PowerBuffer[k * m_Tables.binCount], m_MelBuffer[b + k]);
+
+            if(m_VAD)
+                m_SpeechFlags[currentFrame + b + k] = detectSpeech(m_MelBuffer[b + k], density);
+        }
+    }
+
+    ///*** MFCC matrix, DCT and ceplift in one product
+    applyDCT(frameCount, currentFrame);
+}
+
+/**
+ * @brief Multiplies the block of log mel frames with the liftered DCT matrix
+ *        MFCC(frames x dims) = LogMel(frames x filters) * DCT(filters x dims)
+ *        Four frames share every row of coefficients loaded from cache.
+ * 
+ * @param frameCount    (size_t)   Number of frames in m_MelBuffer
+ * @param currentFrame  (size_t)   Row of the first frame in the MFCC matrix
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::applyDCT(size_t frameCount, size_t currentFrame)
+{
+    size_t k = 0;
+
+    for(; k + 4 <= frameCount; k += 4)
+    {
+        const T *x0 = m_MelBuffer[k], *x1 = m_MelBuffer[k + 1], *x2 = m_MelBuffer[k + 2], *x3 = m_MelBuffer[k + 3];
+        T *y0 = m_MFCCData[currentFrame + k], *y1 = m_MFCCData[currentFrame + k + 1];
+        T *y2 = m_MFCCData[currentFrame + k + 2], *y3 = m_MFCCData[currentFrame + k + 3];
+
+        for(int i = 0; i < m_Tables.dims; i++)
+        {
+            y0[i] = 0;
+            y1[i] = 0;
+            y2[i] = 0;
+            y3[i] = 0;
+        }
+
+        for(int j = 0; j < m_Tables.filters; j++)
+        {
+            const T* c = &m_Tables.dct[j * m_Tables.dims];
+            T a0 = x0[j], a1 = x1[j], a2 = x2[j], a3 = x3[j];
+
+            for(int i = 0; i < m_Tables.dims; i++)
+            {
+                y0[i] += a0 * c[i];
+                y1[i] += a1 * c[i];
+                y2[i] += a2 * c[i];
+                y3[i] += a3 * c[i];
+            }
+        }
+    }
+
+    for(; k < frameCount; k++)
+    {
+        const T* x = m_MelBuffer[k];
+        T* y = m_MFCCData[currentFrame + k];
+
+        for(int i = 0; i < m_Tables.dims; i++)
+        {
+            y[i] = 0;
+        }
+
+        for(int j = 0; j < m_Tables.filters; j++)
+        {
+            const T* c = &m_Tables.dct[j * m_Tables.dims];
+            T a = x[j];
+
+            for(int i = 0; i < m_Tables.dims; i++)
+            {
+                y[i] += a * c[i];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Applies the mel filterbank to one power spectrum and takes the log
+ *        Only the non-zero span of each triangular filter is visited,
+ *        the logs of all bands are taken at once by the vectorized kernel with setFastMath
+ * 
+ * @param power    (double) Power spectrum (binCount)
+ * @param melPower (T)      Log mel power (filters)
+ * @return         (double) Sum of the band powers divided by the filter areas, used by the VAD
+ */
+template<typename T, class Tables>
+double BasicMFCCEngine<T, Tables>::applyFilterBank(const double power[], T melPower[])
+{
+    double density = 0;
+    double* band = m_BandPower.data();
+
+    for(int i = 0; i < m_Tables.filters; i++)
+    {
+        const double* weight = &m_Tables.weights[m_Tables.filterOffset[i]];
+        const double* bin = &power[m_Tables.filterStart[i]];
+        double sum = 0;
+
+        for(int j = 0; j < m_Tables.filterLength[i]; j++)
+        {
+            sum += weight[j] * bin[j];
+        }
+
+        band[i] = sum;
+        density += sum * m_Tables.filterNorm[i];
+    }
+
+    if(m_FastMath)
+    {
+        FastMath::Log(band, band, m_Tables.filters);
+        for(int i = 0; i < m_Tables.filters; i++)
+            melPower[i] = band[i];
+    }
+    else
+    {
+        for(int i = 0; i < m_Tables.filters; i++)
+            melPower[i] = log(band[i]);
+    }
+
+    return density;
+}
+
+/**
+ * @brief Tags one frame as speech (1) or non-speech (0)
+ *        Speech is louder than the noise floor by margin and has a peaky mel spectrum:
+ *        the spectral flatness log(geometric mean / arithmetic mean) of the band power
+ *        densities is below the flatness threshold. The noise floor follows the quietest
+ *        frames and rises slowly, after speech the tag is held for hangover frames.
+ * 
+ * @param melPower (T)      Log mel power of the frame (filters)
+ * @param density  (double) Sum of the band power densities, from applyFilterBank
+ * @return         (unsigned char)
+ */
+template<typename T, class Tables>
+unsigned char BasicMFCCEngine<T, Tables>::detectSpeech(const T melPower[], double density)
+{
+    double energy, flatness, logSum = 0;
+    bool speech;
+
+    for(int i = 0; i < m_Tables.filters; i++)
+    {
+        logSum += melPower[i];
+    }
+
+    energy = log(density / m_Tables.filters);
+    flatness = logSum / m_Tables.filters - m_Tables.meanLogArea - energy;
+
+    if(energy < m_NoiseFloor)
+        m_NoiseFloor = energy;
+    else
+        m_NoiseFloor += NoiseRise;
+
+    speech = energy > m_NoiseFloor + m_VADMargin && flatness < m_VADFlatness;
+    if(speech)
+        m_HangoverLeft = m_VADHangover;
+    else if(m_HangoverLeft > 0)
+    {
+        m_HangoverLeft--;
+        speech = true;
+    }
+
+    return speech ? 1 : 0;
+}
+
+/**
+ * @brief Saves the MFCC extracted data to file
+ * 
+ * @param filePath (string) Path where the MFCC get saved
+ * @return         (bool) If operation was successful
+ */
+template<typename T, class Tables>
+bool BasicMFCCEngine<T, Tables>::Save(const std::string& filePath)
+{
+	size_t frameCount;
+    std::ofstream outFile(filePath);
+
+    if(!outFile.is_open())
+        return false;
+
+    outFile << std::fixed << std::setprecision(6);
+
+    frameCount = m_DoneFrame - m_RowOffset;
+
+    for(size_t i=0; i<frameCount; i++)
+    {
+        for(int j=0; j<GetFeatureDim(); j++)
+            outFile << m_MFCCData[i][j] << " ";
+        outFile << std::endl;
+    }
+
+    outFile.close();
+    return true;
+}
+
+/**
+ * @brief Returns the MFCC data matrix
+ * 
+ * @return Contiguous matrix with MFCC data (frames x dims)
+ */
+template<typename T, class Tables>
+const BasicFeatureMatrix<T>& BasicMFCCEngine<T, Tables>::GetMFCCData()
+{
+    return m_MFCCData;
+}
+
+/**
+ * @brief Returns the complete frames with their speech tags when the VAD is on
+ * 
+ * @return (FeatureView) (frames x FeatureDim)
+ */
+template<typename T, class Tables>
+BasicFeatureView<T> BasicMFCCEngine<T, Tables>::GetFeatures()
+{
+    return rowView(0, m_DoneFrame - m_RowOffset);
+}
+
+/**
+ * @brief Returns the speech tags, one per row of GetMFCCData, empty when the VAD is off
+ * 
+ * @return (vector) 1 speech, 0 non-speech
+ */
+template<typename T, class Tables>
+const std::vector<unsigned char>& BasicMFCCEngine<T, Tables>::GetSpeechFlags()
+{
+    return m_SpeechFlags;
+}
+
+/**
+ * @brief Returns a view on count rows of the MFCC matrix, with the speech tags when the VAD is on
+ * 
+ * @param row   (size_t)
+ * @param count (size_t)
+ * @return      (FeatureView)
+ */
+template<typename T, class Tables>
+BasicFeatureView<T> BasicMFCCEngine<T, Tables>::rowView(size_t row, size_t count)
+{
+    BasicFeatureView<T> view = m_MFCCData.View(row, count);
+
+    if(m_VAD)
+        view.speech = m_SpeechFlags.data() + row;
+
+    return view;
+}
+
+/**
+ * @brief Starts the analyse of a stream given in buffers of any size by AddBuffer
+ *        With maxSize the stream stops after maxSize samples and GetMFCCData holds all frames.
+ *        Without, the stream is unbounded: only the last block of frames is kept in
+ *        GetMFCCData and the frames are passed on by the frame callback.
+ *        The buffers are allocated here, AddBuffer does not allocate memory.
+ * 
+ * @param maxSize (size_t) Maximum number of samples, 0 for an unbounded stream
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::StartAnalyse(size_t maxSize)
+{
+    size_t frameCount;
+
+    if(maxSize == 0)
+    {
+        startStream(0);
+        return;
+    }
+
+    frameCount = countFrames(maxSize);
+    if(frameCount == 0)
+    {
+        m_MFCCData.Clear();
+        m_FrameCount = m_CurrentFrame = m_EmitFrame = m_DoneFrame = m_RowOffset = 0;
+        m_Streaming = false;
+        return;
+    }
+    startStream(frameCount);
+}
+
+/**
+ * @brief Resets the stream state and sizes the buffers
+ * 
+ * @param frameCount (size_t) Number of frames of the stream, 0 for an unbounded stream
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::startStream(size_t frameCount)
+{
+    size_t ringSize = 1;
+
+    m_FrameCount = frameCount;
+    m_CurrentFrame = 0;
+    m_RowOffset = 0;
+    m_DoneFrame = 0;
+    m_EmitFrame = 0;
+    m_DeltaFrame.assign(m_DeltaOrder, 0);
+    m_MFCCData.Clear();
+    if(frameCount > 0)
+        m_MFCCData.Resize(frameCount, GetFeatureDim());
+    else
+        // Room for a block and the frames still needed by the deltas
+        m_MFCCData.Resize(BlockSize + (m_DeltaOrder + 1) * m_DeltaWindow, GetFeatureDim());
+    if(m_VAD)
+        m_SpeechFlags.assign(m_MFCCData.GetRows(), 0);
+    else
+        m_SpeechFlags.clear();
+    m_NoiseFloor = HUGE_VAL;
+    m_HangoverLeft = 0;
+
+    ///*** Ring buffer large enough for a full block of frames, a power of 2 for the index mask
+    while(ringSize < (size_t)(m_Tables.frameSize + BlockSize * m_Tables.frameShift))
+        ringSize <<= 1;
+    if(m_Ring.size() != ringSize)
+        m_Ring.assign(ringSize, 0);
+    m_RingMask = ringSize - 1;
+    m_RingRead = 0;
+    m_RingWrite = 0;
+
+    m_Filter.Reset();
+    m_Streaming = true;
+}
+
+/**
+ * @brief Analyses the next samples of the stream started by StartAnalyse
+ *        The samples not used by a complete frame are kept for the next call.
+ * 
+ * @param data      (short int) data vector
+ * @param sizeData  (size_t)    Lenght of data vector
+ * @return          (bool) False when the stream is not started or the maximum size is reached
+ */
+template<typename T, class Tables>
+bool BasicMFCCEngine<T, Tables>::AddBuffer(const short int data[], size_t sizeData)
+{
+    if(!m_Streaming) return false;
+
+    return feed(data, sizeData);
+}
+
+/**
+ * @brief Conditions the samples into the ring buffer and analyses every complete block of frames
+ * 
+ * @param data      (short int) data vector
+ * @param sizeData  (size_t)    Lenght of data vector
+ * @return          (bool) False when the maximum size is reached
+ */
+template<typename T, class Tables>
+bool BasicMFCCEngine<T, Tables>::feed(const short int data[], size_t sizeData)
+{
+    size_t copied = 0, count, frameCount, start, first, keep;
+    size_t ringSize = m_Ring.size();
+
+
+    ///*** Initialisation
+    if(m_FrameCount > 0 && m_CurrentFrame >= m_FrameCount) return false;
+
+    while(true)
+    {
+        ///*** DC removal and pre-emphasis while filling the ring buffer
+        count = std::min(sizeData - copied, ringSize - (m_RingWrite - m_RingRead));
+        start = m_RingWrite & m_RingMask;
+        first = std::min(count, ringSize - start);
+        m_Filter.Process(&data[copied], first, &m_Ring[start]);
+        m_Filter.Process(&data[copied + first], count - first, &m_Ring[0]);
+        m_RingWrite += count;
+        copied += count;
+
+        ///*** Complete frames, at most one block
+        count = m_RingWrite - m_RingRead;
+        if(count < (size_t)m_Tables.frameSize) break;
+        frameCount = std::min((count - m_Tables.frameSize) / m_Tables.frameShift + 1, (size_t)BlockSize);
+        if(m_FrameCount > 0)
+            frameCount = std::min(frameCount, m_FrameCount - m_CurrentFrame);
+
+        ///*** Apply the window coefficients, a frame may wrap around the end of the ring
+        for(size_t i = 0; i < frameCount; i++)
+        {
+            double* frame = &m_FrameBuffer[i * m_Tables.fftSize];
+
+            start = (m_RingRead + i * m_Tables.frameShift) & m_RingMask;
+            first = std::min((size_t)m_Tables.frameSize, ringSize - start);
+            Filter::Window(&m_Ring[start], &m_Tables.window[0], first, frame);
+            Filter::Window(&m_Ring[0], &m_Tables.window[first], m_Tables.frameSize - first, &frame[first]);
+        }
+
+        ///*** Unbounded stream: move the frames still needed by the deltas to the top
+        if(m_CurrentFrame - m_RowOffset + frameCount > m_MFCCData.GetRows())
+        {
+            keep = std::min(m_CurrentFrame - m_RowOffset, (size_t)((m_DeltaOrder + 1) * m_DeltaWindow));
+            if(keep > 0)
+                memmove(m_MFCCData[0], m_MFCCData[m_CurrentFrame - m_RowOffset - keep], keep * m_MFCCData.GetStride() * sizeof(T));
+            if(keep > 0 && m_VAD)
+                memmove(&m_SpeechFlags[0], &m_SpeechFlags[m_CurrentFrame - m_RowOffset - keep], keep);
+            m_RowOffset = m_CurrentFrame - keep;
+        }
+
+        ///*** Analyse
+        analyseBlock(frameCount, m_CurrentFrame - m_RowOffset);
+        m_CurrentFrame += frameCount;
+        m_RingRead += frameCount * m_Tables.frameShift;
+
+        if(m_FrameCount > 0 && m_CurrentFrame >= m_FrameCount)
+        {
+            computeDeltas(m_CurrentFrame, true);
+            emitFrames();
+            return false;
+        }
+        computeDeltas(m_CurrentFrame, false);
+        emitFrames();
+    }
+
+    return true;
+}
+
+/**
+ * @brief Ends the stream, the last frames waiting for the look-ahead of the deltas are completed
+ *        with the last frame repeated
+ * 
+ * @return (size_t) Number of frames of the stream
+ */
+template<typename T, class Tables>
+size_t BasicMFCCEngine<T, Tables>::EndAnalyse()
+{
+    if(!m_Streaming) return m_DoneFrame;
+
+    computeDeltas(m_CurrentFrame, true);
+    emitFrames();
+    m_Streaming = false;
+
+    return m_DoneFrame;
+}
+
+/**
+ * @brief Passes the frames completed since the last call to the frame callback
+ * 
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::emitFrames()
+{
+    if(m_FrameCallback && m_Streaming && m_DoneFrame > m_EmitFrame)
+        m_FrameCallback(rowView(m_EmitFrame - m_RowOffset, m_DoneFrame - m_EmitFrame), m_EmitFrame);
+    m_EmitFrame = m_DoneFrame;
+}
+
+/**
+ * @brief Computes the regression deltas of the frames whose look-ahead is available
+ *        d(t) = sum_n n*(c(t+n) - c(t-n)) / (2*sum_n n^2), n = 1..window
+ *        The deltas of order k are stored behind the coefficients of order k-1 in the same row,
+ *        frames outside the stream are replaced by the first or last frame.
+ * 
+ * @param frameCount    (size_t)   Number of frames analysed so far
+ * @param final         (bool)     True at the end of the data, no more look-ahead
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::computeDeltas(size_t frameCount, bool final)
+{
+    size_t available, limit, low, high;
+    double norm = 0;
+
+    if(m_DeltaOrder == 0 || frameCount == 0)
+    {
+        m_DoneFrame = frameCount;
+        return;
+    }
+
+    for(int n = 1; n <= m_DeltaWindow; n++)
+        norm += 2.0 * n * n;
+
+    for(int order = 1; order <= m_DeltaOrder; order++)
+    {
+        // Frames with coefficients of the previous order
+        available = order == 1 ? frameCount : m_DeltaFrame[order - 2];
+        if(final)
+            limit = available;
+        else
+            limit = available > (size_t)m_DeltaWindow ? available - m_DeltaWindow : 0;
+
+        for(size_t t = m_DeltaFrame[order - 1]; t < limit; t++)
+        {
+            T* delta = m_MFCCData[t - m_RowOffset] + order * m_Tables.dims;
+
+            for(int i = 0; i < m_Tables.dims; i++)
+            {
+                delta[i] = 0;
+            }
+
+            for(int n = 1; n <= m_DeltaWindow; n++)
+            {
+                high = std::min(t + n, available - 1);
+                low = t >= (size_t)n ? t - n : 0;
+                const T* next = m_MFCCData[high - m_RowOffset] + (order - 1) * m_Tables.dims;
+                const T* prev = m_MFCCData[low - m_RowOffset] + (order - 1) * m_Tables.dims;
+
+                for(int i = 0; i < m_Tables.dims; i++)
+                {
+                    delta[i] += n * (next[i] - prev[i]);
+                }
+            }
+
+            for(int i = 0; i < m_Tables.dims; i++)
+            {
+                delta[i] /= norm;
+            }
+        }
+        m_DeltaFrame[order - 1] = std::max(m_DeltaFrame[order - 1], limit);
+    }
+    m_DoneFrame = m_DeltaFrame[m_DeltaOrder - 1];
+}
+
+/**
+ * @brief Adds delta (order 1) and delta-delta (order 2) coefficients to the features
+ *        The features become dims*(order+1) wide, a stream lags order*window frames behind.
+ *        Takes effect with the next Analyse or StartAnalyse.
+ * 
+ * @param order  (int) 0: none, 1: deltas, 2: deltas and delta-deltas
+ * @param window (int) Frames on each side of the regression
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setDeltas(int order, int window)
+{
+    m_DeltaOrder = std::max(0, std::min(order, 2));
+    m_DeltaWindow = std::max(1, window);
+}
+
+/**
+ * @brief Sets the pre-emphasis applied to the samples before framing, 0 turns it off (default)
+ *        Takes effect with the next Analyse or StartAnalyse.
+ * 
+ * @param coefficient (double) typically 0.97
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setPreEmphasis(double coefficient)
+{
+    m_Filter.setEmphasis(coefficient);
+}
+
+/**
+ * @brief Sets the DC blocker applied to the samples before the pre-emphasis, 0 turns it off (default)
+ *        Takes effect with the next Analyse or StartAnalyse.
+ * 
+ * @param pole (double) typically 0.999
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setDCRemoval(double pole)
+{
+    m_Filter.setDCRemoval(pole);
+}
+
+/**
+ * @brief Turns on the voice activity detection of the analyse (off by default)
+ *        Every frame is tagged as speech or non-speech, the tags are found in GetSpeechFlags,
+ *        the views of GetFeatures and of the frame callback. The features are not changed.
+ *        Takes effect with the next Analyse or StartAnalyse.
+ * 
+ * @param enable   (bool)
+ * @param margin   (double) Log power above the noise floor needed for speech
+ * @param flatness (double) Maximum spectral flatness of speech, log domain (<= 0, 0 is white noise)
+ * @param hangover (int)    Frames still tagged as speech after the end of speech
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setVAD(bool enable, double margin, double flatness, int hangover)
+{
+    m_VAD = enable;
+    m_VADMargin = margin;
+    m_VADFlatness = flatness;
+    m_VADHangover = std::max(0, hangover);
+}
+
+/**
+ * @brief Takes the logs of the filterbank with the polynomial kernel of FastMath instead of libm
+ *        The features differ by a few 1e-14 (double), see FastMath for the bounds.
+ *        Takes effect with the next Analyse or StartAnalyse.
+ * 
+ * @param enable (bool)
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setFastMath(bool enable)
+{
+    m_FastMath = enable;
+}
+
+/**
+ * @brief Returns the number of features per frame
+ * 
+ * @return (int) dims*(delta order+1)
+ */
+template<typename T, class Tables>
+int BasicMFCCEngine<T, Tables>::GetFeatureDim()
+{
+    return m_Tables.dims * (m_DeltaOrder + 1);
+}
+
+/**
+ * @brief Sets the function called with every block of frames analysed by AddBuffer
+ * 
+ * @param callback (FrameCallback) Empty function to disable
+ */
+template<typename T, class Tables>
+void BasicMFCCEngine<T, Tables>::setFrameCallback(FrameCallback callback)
+{
+    m_FrameCallback = callback;
+}
+
+/**
+ * @brief Returns the number of complete frames, in a stream all frames since StartAnalyse
+ *        without the ones waiting for the look-ahead of the deltas
+ * 
+ * @return (size_t)
+ */
+template<typename T, class Tables>
+size_t BasicMFCCEngine<T, Tables>::GetFrameCount()
+{
+    return m_DoneFrame;
+}
+
+/**
+ * @brief Returns the length of the FFT, frames shorter than it are zero padded
+ * 
+ * @return (int)
+ */
+template<typename T, class Tables>
+int BasicMFCCEngine<T, Tables>::GetFFTSize()
+{
+    return m_Tables.fftSize;
+}
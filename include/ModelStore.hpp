@@ -0,0 +1,168 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+
+#include "FeatureMatrix.hpp"
+
+/**
+ * @brief Read-only window on the scoring parameters of one GMM, in a BasicModelStore or a training model
+ *        Every parameter is one array, the rows of quadCoeff are stride apart.
+ *
+ */
+template<typename T>
+struct BasicModelView
+{
+    const T* quadCoeff;     // exponent coefficients on [x^2, x, 1] (2*MfccDim+1 rows x MixDim)
+    const T* weight;        // mixture weights (MixDim)
+    const T* expCoeff;      // gaussian normalisation (MixDim)
+    size_t stride;
+
+    BasicModelView() : quadCoeff(nullptr), weight(nullptr), expCoeff(nullptr), stride(0) {}
+    BasicModelView(const T* quadCoeff, const T* weight, const T* expCoeff, size_t stride) : quadCoeff(quadCoeff), weight(weight), expCoeff(expCoeff), stride(stride) {}
+
+    const T* QuadRow(size_t row) const { return quadCoeff + row * stride; }
+};
+
+/**
+ * @brief Scoring parameters of all models of a classifier in one aligned buffer, T is double or float
+ *        A model is a block of 2*MfccDim+3 rows: the exponent coefficients, the weights and the
+ *        normalisation, each row starts on a cache line. The blocks follow each other in the order
+ *        of the model IDs, so scoring all models is a linear sweep without allocation.
+ *        The labels are interned, one model per label: adding a known label replaces its model.
+ *
+ */
+template<typename T>
+class BasicModelStore
+{
+private:
+    /* data */
+    int m_MixDim;
+    int m_QuadRows;
+    int m_BlockRows;
+    BasicFeatureMatrix<T> m_Data;
+    std::vector<std::string> m_Labels;
+    std::unordered_map<std::string, int> m_Ids;
+
+public:
+    BasicModelStore(int mixDim, int mfccDim);
+    virtual ~BasicModelStore();
+
+    int Add(const std::string& label, const BasicModelView<T>& model);
+    int Find(const std::string& label) const;
+    size_t GetCount() const;
+    const std::string& GetLabel(int id) const;
+    BasicModelView<T> View(int id) const;
+    void Clear();
+};
+
+/**
+ * @brief Construct an empty BasicModelStore object
+ *
+ * @param mixDim  (int) Number of gaussian components
+ * @param mfccDim (int) Number of features per frame
+ */
+template<typename T>
+BasicModelStore<T>::BasicModelStore(int mixDim, int mfccDim)
+{
+    m_MixDim = mixDim;
+    m_QuadRows = 2 * mfccDim + 1;
+    m_BlockRows = m_QuadRows + 2;
+    m_Data.Resize(0, mixDim);
+}
+
+template<typename T>
+BasicModelStore<T>::~BasicModelStore()
+{
+    Clear();
+}
+
+/**
+ * @brief Copies a model into the store
+ *
+ * @param label (string)    Name of the model
+ * @param model (ModelView) Parameters, with the dimensions of the store
+ * @return      (int)       ID of the model, the one of label if it is known
+ */
+template<typename T>
+int BasicModelStore<T>::Add(const std::string& label, const BasicModelView<T>& model)
+{
+    int id = Find(label);
+    T* block;
+
+    if(id < 0)
+    {
+        id = (int)m_Labels.size();
+        m_Labels.push_back(label);
+        m_Ids[label] = id;
+        m_Data.Resize((size_t)(id + 1) * m_BlockRows, m_MixDim);
+    }
+
+    block = m_Data[(size_t)id * m_BlockRows];
+    for(int k = 0; k < m_QuadRows; k++)
+        memcpy(block + k * m_Data.GetStride(), model.QuadRow(k), m_MixDim * sizeof(T));
+    memcpy(block + m_QuadRows * m_Data.GetStride(), model.weight, m_MixDim * sizeof(T));
+    memcpy(block + (m_QuadRows + 1) * m_Data.GetStride(), model.expCoeff, m_MixDim * sizeof(T));
+
+    return id;
+}
+
+/**
+ * @brief Returns the ID of a label
+ *
+ * @param label (string)
+ * @return      (int) -1 if the label is unknown
+ */
+template<typename T>
+int BasicModelStore<T>::Find(const std::string& label) const
+{
+    typename std::unordered_map<std::string, int>::const_iterator it = m_Ids.find(label);
+
+    return it != m_Ids.end() ? it->second : -1;
+}
+
+template<typename T>
+size_t BasicModelStore<T>::GetCount() const
+{
+    return m_Labels.size();
+}
+
+template<typename T>
+const std::string& BasicModelStore<T>::GetLabel(int id) const
+{
+    return m_Labels[id];
+}
+
+/**
+ * @brief Returns the parameters of a model, valid until the next Add or Clear
+ *
+ * @param id (int)
+ * @return   (ModelView)
+ */
+template<typename T>
+BasicModelView<T> BasicModelStore<T>::View(int id) const
+{
+    const T* block = m_Data[(size_t)id * m_BlockRows];
+    size_t stride = m_Data.GetStride();
+
+    return BasicModelView<T>(block, block + m_QuadRows * stride, block + (m_QuadRows + 1) * stride, stride);
+}
+
+/**
+ * @brief Removes all models, the buffer is kept
+ *
+ */
+template<typename T>
+void BasicModelStore<T>::Clear()
+{
+    m_Data.Clear();
+    m_Labels.clear();
+    m_Ids.clear();
+}
+
+typedef BasicModelView<double> ModelView;
+typedef BasicModelView<float> ModelViewF;
+typedef BasicModelStore<double> ModelStore;
+typedef BasicModelStore<float> ModelStoreF;
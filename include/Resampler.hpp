@@ -0,0 +1,351 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <math.h>
+
+#include "Simd.hpp"
+
+/**
+ * @brief Polyphase FIR sample rate converter by the ratio L/M (out/in reduced by their gcd)
+ *        The prototype is a Kaiser windowed sinc (Attenuation dB) with its cutoff at the lower Nyquist
+ *        frequency, it is split into L phases of Taps coefficients so every output costs one dot
+ *        product of Taps samples, computed in float with SimdFloat (24 bits for 16 bit samples).
+ *        The passband, by default Rolloff of the lower Nyquist frequency, is kept free of aliasing:
+ *        the transition band ends where it folds back onto the passband. A narrower passband gives
+ *        a shorter filter, but only if the consumer of the signal does not use the band above it.
+ *        e.g. 48000 -> 16000: L = 1, M = 3     44100 -> 16000: L = 160, M = 441     8000 -> 16000: L = 2, M = 1
+ *        The state is carried across chunks. The output is delayed by GetDelay samples, a whole
+ *        number: drop that many at the start and Flush them at the end to keep the signal aligned.
+ *
+ */
+class Resampler
+{
+private:
+    /* data */
+    void setCoefficients(double passband);
+    static double besselI0(double x);
+    static int gcd(int a, int b);
+
+    int m_InputRate;
+    int m_OutputRate;
+    int m_Up;
+    int m_Down;
+    int m_Taps;
+
+    int m_Delay;
+
+    // Phase p holds h[p + (Taps-1-j)*L] at j, the oldest sample of the window comes first
+    std::vector<float> m_Coeffs;
+
+    // Taps-1 samples of history followed by at most ChunkSize new samples
+    std::vector<float> m_History;
+    // Next output: newest sample of its window relative to the first new sample, and its phase
+    size_t m_Index;
+    int m_Phase;
+
+    // Widest passband, part of the lower Nyquist frequency
+    static constexpr double Rolloff = 0.9;
+    // Stopband, far below the dynamic range the log filterbank energies resolve
+    static constexpr double Attenuation = 60.0;
+    static constexpr double PI = 3.14159265358979323846;
+    // Samples converted per step of Process
+    static constexpr size_t ChunkSize = 1024;
+    // One register of the widest SIMD, the same filter for every width
+    static constexpr int TapBlock = 16;
+
+public:
+    Resampler();
+    Resampler(int inputRate, int outputRate, double passband = 0);
+    ~Resampler();
+
+    bool IsActive() const;
+    int GetInputRate() const;
+    int GetOutputRate() const;
+    int GetTaps() const;
+    size_t GetDelay() const;
+    size_t GetOutputSize(size_t inputSize) const;
+    void Reset();
+    size_t Process(const short int input[], size_t size, short int output[]);
+    size_t Flush(short int output[]);
+};
+
+/**
+ * @brief Construct a new Resampler object, the samples are copied unchanged
+ *
+ */
+Resampler::Resampler() : Resampler(16000, 16000)
+{
+}
+
+/**
+ * @brief Construct a new Resampler object
+ *
+ * @param inputRate  (int)    Sample rate of the input, e.g. 48000
+ * @param outputRate (int)    Sample rate of the output, e.g. 16000
+ * @param passband   (double) Highest frequency kept without aliasing (Hz), 0 for Rolloff * lower rate / 2
+ */
+Resampler::Resampler(int inputRate, int outputRate, double passband) : m_InputRate(inputRate), m_OutputRate(outputRate)
+{
+    int divisor = gcd(inputRate, outputRate);
+
+    m_Up = outputRate / divisor;
+    m_Down = inputRate / divisor;
+    m_Taps = 0;
+    m_Delay = 0;
+
+    if(IsActive())
+        setCoefficients(passband);
+
+    Reset();
+}
+
+Resampler::~Resampler()
+{
+    m_Coeffs.clear();
+    m_History.clear();
+}
+
+/**
+ * @brief Designs the prototype low-pass at the upsampled rate and splits it into the phases
+ *        Transition band [passband, lower rate - passband], Kaiser: length = (A-8) / (2.285 * 2pi * width)
+ *        The length is odd and its center a multiple of M, so the group delay is a whole number
+ *        of output samples. The phases are padded with zeros to a multiple of TapBlock,
+ *        every phase is scaled to a DC gain of 1.
+ *
+ * @param passband (double) Hz
+ */
+void Resampler::setCoefficients(double passband)
+{
+    double lower = std::min(m_InputRate, m_OutputRate);
+    double cutoff, width, beta, center, x, sum;
+    int length;
+
+    if(passband <= 0 || passband > Rolloff * lower / 2)
+        passband = Rolloff * lower / 2;
+
+    ///*** In cycles per upsampled sample, length - 1 rounded up to a multiple of 2M
+    cutoff = 0.5 * lower / ((double)m_Up * m_InputRate);
+    width = (lower - 2 * passband) / ((double)m_Up * m_InputRate);
+    beta = 0.1102 * (Attenuation - 8.7);
+    length = (int)ceil((Attenuation - 8) / (2.285 * 2 * PI * width));
+    length = (length - 1 + 2 * m_Down - 1) / (2 * m_Down) * (2 * m_Down) + 1;
+    center = (length - 1) / 2.0;
+    m_Delay = (length - 1) / 2 / m_Down;
+    m_Taps = (length + m_Up - 1) / m_Up;
+    m_Taps = (m_Taps + TapBlock - 1) / TapBlock * TapBlock;
+
+    ///*** Windowed sinc, zero after length
+    std::vector<double> prototype((size_t)m_Taps * m_Up, 0.0);
+    for(int n = 0; n < length; n++)
+    {
+        x = n - center;
+        prototype[n] = x == 0 ? 2 * cutoff : sin(2 * PI * cutoff * x) / (PI * x);
+        prototype[n] *= besselI0(beta * sqrt(std::max(0.0, 1 - (x / center) * (x / center)))) / besselI0(beta);
+    }
+
+    ///*** Phases, reversed so the window of samples is read forwards
+    m_Coeffs.assign((size_t)m_Up * m_Taps, 0.0f);
+    for(int p = 0; p < m_Up; p++)
+    {
+        float* phase = &m_Coeffs[(size_t)p * m_Taps];
+
+        sum = 0;
+        for(int j = 0; j < m_Taps; j++)
+            sum += prototype[p + j * m_Up];
+        for(int j = 0; j < m_Taps; j++)
+            phase[m_Taps - 1 - j] = (float)(prototype[p + j * m_Up] / sum);
+    }
+}
+
+/**
+ * @brief Returns false if the input and output rates are the same
+ *
+ * @return (bool)
+ */
+bool Resampler::IsActive() const
+{
+    return m_Up != m_Down;
+}
+
+int Resampler::GetInputRate() const
+{
+    return m_InputRate;
+}
+
+int Resampler::GetOutputRate() const
+{
+    return m_OutputRate;
+}
+
+/**
+ * @brief Returns the number of coefficients per output sample
+ *
+ * @return (int)
+ */
+int Resampler::GetTaps() const
+{
+    return m_Taps;
+}
+
+/**
+ * @brief Returns the group delay of the filter
+ *
+ * @return (size_t) Output samples
+ */
+size_t Resampler::GetDelay() const
+{
+    return m_Delay;
+}
+
+/**
+ * @brief Returns the number of output samples of inputSize input samples after Reset,
+ *        later in the stream it is the largest possible number
+ *
+ * @param inputSize (size_t)
+ * @return          (size_t)
+ */
+size_t Resampler::GetOutputSize(size_t inputSize) const
+{
+    return (inputSize * m_Up + m_Down - 1) / m_Down;
+}
+
+/**
+ * @brief Starts a new stream, the samples before it are taken as 0
+ *
+ */
+void Resampler::Reset()
+{
+    m_History.assign(std::max(m_Taps - 1, 0) + ChunkSize, 0.0f);
+    m_Index = 0;
+    m_Phase = 0;
+}
+
+/**
+ * @brief Converts the next chunk of the stream
+ *        Chunks can have any size, the result is the same as for the whole signal.
+ *        Every output sample is a dot product of the last Taps input samples with one phase.
+ *
+ * @param input  (short int) Samples of the next chunk
+ * @param size   (size_t)    Number of samples
+ * @param output (short int) Converted samples, room for GetOutputSize(size)
+ * @return       (size_t)    Number of converted samples
+ */
+size_t Resampler::Process(const short int input[], size_t size, short int output[])
+{
+    size_t written = 0, count, history = m_Taps - 1;
+    size_t index = m_Index, indexStep = m_Down / m_Up;
+    int phase = m_Phase, phaseStep = m_Down % m_Up;
+    int blocks = m_Taps - m_Taps % (2 * SimdFloat::Lanes);
+    float* samples = m_History.data();
+    double value;
+
+    if(!IsActive())
+    {
+        memcpy(output, input, size * sizeof(short int));
+        return size;
+    }
+
+    for(size_t done = 0; done < size; done += count)
+    {
+        count = std::min(size - done, ChunkSize);
+        for(size_t i = 0; i < count; i++)
+            samples[history + i] = input[done + i];
+
+        ///*** Outputs whose newest sample is in this chunk, each step advances M/L input samples
+        for(; index < count; index += indexStep)
+        {
+            const float* window = &samples[index];
+            const float* coeffs = &m_Coeffs[(size_t)phase * m_Taps];
+            SimdFloat even = SimdFloat::Broadcast(0.0f), odd = even;
+
+            // Two independent sums, an array of them would stay in memory
+            for(int j = 0; j < blocks; j += 2 * SimdFloat::Lanes)
+            {
+                even = even + SimdFloat::Load(&coeffs[j]) * SimdFloat::Load(&window[j]);
+                odd = odd + SimdFloat::Load(&coeffs[j + SimdFloat::Lanes]) * SimdFloat::Load(&window[j + SimdFloat::Lanes]);
+            }
+            for(int j = blocks; j < m_Taps; j += SimdFloat::Lanes)
+                even = even + SimdFloat::Load(&coeffs[j]) * SimdFloat::Load(&window[j]);
+
+            // Rounded to nearest, lrint would be a call to libm
+            value = std::max(-32768.0, std::min(32767.0, (double)(even + odd).Sum()));
+            output[written++] = (short int)(value + copysign(0.5, value));
+
+            phase += phaseStep;
+            if(phase >= m_Up)
+            {
+                phase -= m_Up;
+                index++;
+            }
+        }
+        index -= count;
+
+        ///*** Keep the last Taps-1 samples for the next chunk
+        memmove(&samples[0], &samples[count], history * sizeof(float));
+    }
+
+    m_Index = index;
+    m_Phase = phase;
+    return written;
+}
+
+/**
+ * @brief Ends the stream with the last GetDelay output samples, still in the filter
+ *        The input goes on with zeros, Reset starts the next stream.
+ *
+ * @param output (short int) Room for GetDelay samples
+ * @return       (size_t)    Number of samples, GetDelay
+ */
+size_t Resampler::Flush(short int output[])
+{
+    std::vector<short int> zeros, tail;
+    size_t written;
+
+    if(!IsActive() || m_Delay == 0) return 0;
+
+    // Enough zeros for GetDelay more outputs, whatever the phase
+    zeros.assign(((size_t)m_Delay * m_Down + m_Up - 1) / m_Up, 0);
+    tail.resize(GetOutputSize(zeros.size()) + 1);
+    written = std::min(Process(zeros.data(), zeros.size(), tail.data()), (size_t)m_Delay);
+    memcpy(output, tail.data(), written * sizeof(short int));
+
+    return written;
+}
+
+/**
+ * @brief Greatest common divisor
+ *
+ * @param a (int)
+ * @param b (int)
+ * @return  (int)
+ */
+int Resampler::gcd(int a, int b)
+{
+    while(b != 0)
+    {
+        int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/**
+ * @brief Modified Bessel function of order 0 for the Kaiser window, series until it converges
+ *
+ * @param x (double)
+ * @return  (double)
+ */
+double Resampler::besselI0(double x)
+{
+    double sum = 1, term = 1;
+
+    for(int k = 1; k < 50 && term > 1e-17 * sum; k++)
+    {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
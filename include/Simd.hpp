@@ -0,0 +1,648 @@
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+
+#if defined(__AVX512F__) || defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Pack of doubles processed by one SIMD register
+ *        AVX-512: 8 lanes, AVX/AVX2: 4 lanes, otherwise a scalar fallback
+ *        with 4 lanes which the compiler may still map to SSE2.
+ *        Build with -march=native (USE_NATIVE_ARCH) to enable the wide kernels.
+ */
+struct SimdDouble
+{
+#if defined(__AVX512F__)
+    static constexpr int Lanes = 8;
+    __m512d v;
+#elif defined(__AVX__)
+    static constexpr int Lanes = 4;
+    __m256d v;
+#else
+    static constexpr int Lanes = 4;
+    alignas(32) double v[4];
+#endif
+
+    static SimdDouble Load(const double* p);
+    static SimdDouble Broadcast(double x);
+    static SimdDouble Min(const SimdDouble& a, const SimdDouble& b);
+    static SimdDouble Max(const SimdDouble& a, const SimdDouble& b);
+    static SimdDouble Select(const SimdDouble& a, const SimdDouble& b, const SimdDouble& x, const SimdDouble& y);
+    void Store(double* p) const;
+    double Sum() const;
+    SimdDouble Scale(const SimdDouble& k) const;
+    SimdDouble Exponent(SimdDouble& mantissa) const;
+};
+
+/**
+ * @brief Loads Lanes doubles, p does not need to be aligned
+ *
+ * @param p (double)
+ * @return  (SimdDouble)
+ */
+inline SimdDouble SimdDouble::Load(const double* p)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_loadu_pd(p);
+#elif defined(__AVX__)
+    r.v = _mm256_loadu_pd(p);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = p[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Sets all lanes to x
+ *
+ * @param x (double)
+ * @return  (SimdDouble)
+ */
+inline SimdDouble SimdDouble::Broadcast(double x)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_set1_pd(x);
+#elif defined(__AVX__)
+    r.v = _mm256_set1_pd(x);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = x;
+#endif
+    return r;
+}
+
+/**
+ * @brief Lane-wise a < b ? a : b, b where a is NaN
+ *
+ * @param a (SimdDouble)
+ * @param b (SimdDouble)
+ * @return  (SimdDouble)
+ */
+inline SimdDouble SimdDouble::Min(const SimdDouble& a, const SimdDouble& b)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_min_pd(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_min_pd(a.v, b.v);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Lane-wise a > b ? a : b, b where a is NaN
+ *
+ * @param a (SimdDouble)
+ * @param b (SimdDouble)
+ * @return  (SimdDouble)
+ */
+inline SimdDouble SimdDouble::Max(const SimdDouble& a, const SimdDouble& b)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_max_pd(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_max_pd(a.v, b.v);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Lane-wise a < b ? x : y, without a branch
+ *
+ * @param a (SimdDouble)
+ * @param b (SimdDouble)
+ * @param x (SimdDouble) Taken where a < b
+ * @param y (SimdDouble) Taken elsewhere, also where a or b is NaN
+ * @return  (SimdDouble)
+ */
+inline SimdDouble SimdDouble::Select(const SimdDouble& a, const SimdDouble& b, const SimdDouble& x, const SimdDouble& y)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_mask_blend_pd(_mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ), y.v, x.v);
+#elif defined(__AVX__)
+    r.v = _mm256_blendv_pd(y.v, x.v, _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ));
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = a.v[i] < b.v[i] ? x.v[i] : y.v[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Stores Lanes doubles, p does not need to be aligned
+ *
+ * @param p (double)
+ */
+inline void SimdDouble::Store(double* p) const
+{
+#if defined(__AVX512F__)
+    _mm512_storeu_pd(p, v);
+#elif defined(__AVX__)
+    _mm256_storeu_pd(p, v);
+#else
+    for(int i = 0; i < Lanes; i++) p[i] = v[i];
+#endif
+}
+
+/**
+ * @brief Returns the sum of the lanes, added pairwise in registers
+ *
+ * @return (double)
+ */
+inline double SimdDouble::Sum() const
+{
+#if defined(__AVX512F__)
+    __m256d half = _mm256_add_pd(_mm512_castpd512_pd256(v), _mm512_extractf64x4_pd(v, 1));
+#elif defined(__AVX__)
+    __m256d half = v;
+#endif
+#if defined(__AVX512F__) || defined(__AVX__)
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(half), _mm256_extractf128_pd(half, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+#else
+    return (v[0] + v[2]) + (v[1] + v[3]);
+#endif
+}
+
+/**
+ * @brief Returns this * 2^k, exact for integral k in [-1022, 1023]
+ *        The bits of 2^k are built from k + 2^52 + 1023, whose low bits hold the biased exponent
+ *
+ * @param k (SimdDouble) Integral exponents
+ * @return  (SimdDouble)
+ */
+inline SimdDouble SimdDouble::Scale(const SimdDouble& k) const
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_scalef_pd(v, k.v);
+#elif defined(__AVX__)
+    __m256d biased = _mm256_add_pd(k.v, _mm256_set1_pd(4503599627371519.0));
+#if defined(__AVX2__)
+    __m256i bits = _mm256_slli_epi64(_mm256_castpd_si256(biased), 52);
+#else
+    __m256i bits = _mm256_castsi128_si256(_mm_slli_epi64(_mm_castpd_si128(_mm256_castpd256_pd128(biased)), 52));
+    bits = _mm256_insertf128_si256(bits, _mm_slli_epi64(_mm_castpd_si128(_mm256_extractf128_pd(biased, 1)), 52), 1);
+#endif
+    r.v = _mm256_mul_pd(v, _mm256_castsi256_pd(bits));
+#else
+    double scale;
+    uint64_t bits;
+    for(int i = 0; i < Lanes; i++)
+    {
+        scale = k.v[i] + 4503599627371519.0;
+        memcpy(&bits, &scale, sizeof(bits));
+        bits <<= 52;
+        memcpy(&scale, &bits, sizeof(scale));
+        r.v[i] = v[i] * scale;
+    }
+#endif
+    return r;
+}
+
+/**
+ * @brief Splits positive normal values into mantissa * 2^exponent, the result is undefined for others
+ *
+ * @param mantissa (SimdDouble) Receives the mantissas in [1, 2)
+ * @return         (SimdDouble) Exponents
+ */
+inline SimdDouble SimdDouble::Exponent(SimdDouble& mantissa) const
+{
+    SimdDouble e;
+#if defined(__AVX512F__)
+    e.v = _mm512_getexp_pd(v);
+    mantissa.v = _mm512_getmant_pd(v, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero);
+#elif defined(__AVX__)
+    const __m256d fraction = _mm256_castsi256_pd(_mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+#if defined(__AVX2__)
+    __m256i bits = _mm256_srli_epi64(_mm256_castpd_si256(v), 52);
+#else
+    __m256i bits = _mm256_castsi128_si256(_mm_srli_epi64(_mm_castpd_si128(_mm256_castpd256_pd128(v)), 52));
+    bits = _mm256_insertf128_si256(bits, _mm_srli_epi64(_mm_castpd_si128(_mm256_extractf128_pd(v, 1)), 52), 1);
+#endif
+    // 2^52 + biased exponent, minus 2^52 + 1023
+    e.v = _mm256_or_pd(_mm256_castsi256_pd(bits), _mm256_set1_pd(4503599627370496.0));
+    e.v = _mm256_sub_pd(e.v, _mm256_set1_pd(4503599627371519.0));
+    mantissa.v = _mm256_or_pd(_mm256_and_pd(v, fraction), _mm256_set1_pd(1.0));
+#else
+    uint64_t bits, exponent;
+    for(int i = 0; i < Lanes; i++)
+    {
+        memcpy(&bits, &v[i], sizeof(bits));
+        exponent = 0x4330000000000000ULL | (bits >> 52);
+        memcpy(&e.v[i], &exponent, sizeof(exponent));
+        e.v[i] -= 4503599627371519.0;
+        bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+        memcpy(&mantissa.v[i], &bits, sizeof(bits));
+    }
+#endif
+    return e;
+}
+
+inline SimdDouble operator+(const SimdDouble& a, const SimdDouble& b)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_add_pd(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_add_pd(a.v, b.v);
+#else
+    for(int i = 0; i < SimdDouble::Lanes; i++) r.v[i] = a.v[i] + b.v[i];
+#endif
+    return r;
+}
+
+inline SimdDouble operator-(const SimdDouble& a, const SimdDouble& b)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_sub_pd(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_sub_pd(a.v, b.v);
+#else
+    for(int i = 0; i < SimdDouble::Lanes; i++) r.v[i] = a.v[i] - b.v[i];
+#endif
+    return r;
+}
+
+inline SimdDouble operator*(const SimdDouble& a, const SimdDouble& b)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_mul_pd(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_mul_pd(a.v, b.v);
+#else
+    for(int i = 0; i < SimdDouble::Lanes; i++) r.v[i] = a.v[i] * b.v[i];
+#endif
+    return r;
+}
+
+inline SimdDouble operator/(const SimdDouble& a, const SimdDouble& b)
+{
+    SimdDouble r;
+#if defined(__AVX512F__)
+    r.v = _mm512_div_pd(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_div_pd(a.v, b.v);
+#else
+    for(int i = 0; i < SimdDouble::Lanes; i++) r.v[i] = a.v[i] / b.v[i];
+#endif
+    return r;
+}
+
+inline SimdDouble operator+(const SimdDouble& a, double b)
+{
+    return a + SimdDouble::Broadcast(b);
+}
+
+inline SimdDouble operator-(const SimdDouble& a, double b)
+{
+    return a - SimdDouble::Broadcast(b);
+}
+
+inline SimdDouble operator*(double a, const SimdDouble& b)
+{
+    return SimdDouble::Broadcast(a) * b;
+}
+
+inline SimdDouble operator*(const SimdDouble& a, double b)
+{
+    return a * SimdDouble::Broadcast(b);
+}
+
+/**
+ * @brief Pack of floats processed by one SIMD register, twice the lanes of SimdDouble
+ *        AVX-512: 16 lanes, AVX/AVX2: 8 lanes, otherwise a scalar fallback with 8 lanes.
+ */
+struct SimdFloat
+{
+#if defined(__AVX512F__)
+    static constexpr int Lanes = 16;
+    __m512 v;
+#elif defined(__AVX__)
+    static constexpr int Lanes = 8;
+    __m256 v;
+#else
+    static constexpr int Lanes = 8;
+    alignas(32) float v[8];
+#endif
+
+    static SimdFloat Load(const float* p);
+    static SimdFloat Broadcast(float x);
+    static SimdFloat Min(const SimdFloat& a, const SimdFloat& b);
+    static SimdFloat Max(const SimdFloat& a, const SimdFloat& b);
+    static SimdFloat Select(const SimdFloat& a, const SimdFloat& b, const SimdFloat& x, const SimdFloat& y);
+    void Store(float* p) const;
+    float Sum() const;
+    SimdFloat Scale(const SimdFloat& k) const;
+    SimdFloat Exponent(SimdFloat& mantissa) const;
+};
+
+/**
+ * @brief Loads Lanes floats, p does not need to be aligned
+ *
+ * @param p (float)
+ * @return  (SimdFloat)
+ */
+inline SimdFloat SimdFloat::Load(const float* p)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_loadu_ps(p);
+#elif defined(__AVX__)
+    r.v = _mm256_loadu_ps(p);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = p[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Sets all lanes to x
+ *
+ * @param x (float)
+ * @return  (SimdFloat)
+ */
+inline SimdFloat SimdFloat::Broadcast(float x)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_set1_ps(x);
+#elif defined(__AVX__)
+    r.v = _mm256_set1_ps(x);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = x;
+#endif
+    return r;
+}
+
+/**
+ * @brief Lane-wise a < b ? a : b, b where a is NaN
+ *
+ * @param a (SimdFloat)
+ * @param b (SimdFloat)
+ * @return  (SimdFloat)
+ */
+inline SimdFloat SimdFloat::Min(const SimdFloat& a, const SimdFloat& b)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_min_ps(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_min_ps(a.v, b.v);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Lane-wise a > b ? a : b, b where a is NaN
+ *
+ * @param a (SimdFloat)
+ * @param b (SimdFloat)
+ * @return  (SimdFloat)
+ */
+inline SimdFloat SimdFloat::Max(const SimdFloat& a, const SimdFloat& b)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_max_ps(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_max_ps(a.v, b.v);
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Lane-wise a < b ? x : y, without a branch
+ *
+ * @param a (SimdFloat)
+ * @param b (SimdFloat)
+ * @param x (SimdFloat) Taken where a < b
+ * @param y (SimdFloat) Taken elsewhere, also where a or b is NaN
+ * @return  (SimdFloat)
+ */
+inline SimdFloat SimdFloat::Select(const SimdFloat& a, const SimdFloat& b, const SimdFloat& x, const SimdFloat& y)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ), y.v, x.v);
+#elif defined(__AVX__)
+    r.v = _mm256_blendv_ps(y.v, x.v, _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ));
+#else
+    for(int i = 0; i < Lanes; i++) r.v[i] = a.v[i] < b.v[i] ? x.v[i] : y.v[i];
+#endif
+    return r;
+}
+
+/**
+ * @brief Stores Lanes floats, p does not need to be aligned
+ *
+ * @param p (float)
+ */
+inline void SimdFloat::Store(float* p) const
+{
+#if defined(__AVX512F__)
+    _mm512_storeu_ps(p, v);
+#elif defined(__AVX__)
+    _mm256_storeu_ps(p, v);
+#else
+    for(int i = 0; i < Lanes; i++) p[i] = v[i];
+#endif
+}
+
+/**
+ * @brief Returns the sum of the lanes, added pairwise in registers
+ *
+ * @return (float)
+ */
+inline float SimdFloat::Sum() const
+{
+#if defined(__AVX512F__)
+    __m256 half = _mm256_add_ps(_mm512_castps512_ps256(v), _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+#elif defined(__AVX__)
+    __m256 half = v;
+#endif
+#if defined(__AVX512F__) || defined(__AVX__)
+    __m128 quad = _mm_add_ps(_mm256_castps256_ps128(half), _mm256_extractf128_ps(half, 1));
+    __m128 pair = _mm_add_ps(quad, _mm_movehl_ps(quad, quad));
+    return _mm_cvtss_f32(_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, 1)));
+#else
+    return ((v[0] + v[4]) + (v[2] + v[6])) + ((v[1] + v[5]) + (v[3] + v[7]));
+#endif
+}
+
+/**
+ * @brief Returns this * 2^k, exact for integral k in [-126, 127]
+ *
+ * @param k (SimdFloat) Integral exponents
+ * @return  (SimdFloat)
+ */
+inline SimdFloat SimdFloat::Scale(const SimdFloat& k) const
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_scalef_ps(v, k.v);
+#elif defined(__AVX__)
+    __m256 biased = _mm256_add_ps(k.v, _mm256_set1_ps(8388735.0f));
+#if defined(__AVX2__)
+    __m256i bits = _mm256_slli_epi32(_mm256_castps_si256(biased), 23);
+#else
+    __m256i bits = _mm256_castsi128_si256(_mm_slli_epi32(_mm_castps_si128(_mm256_castps256_ps128(biased)), 23));
+    bits = _mm256_insertf128_si256(bits, _mm_slli_epi32(_mm_castps_si128(_mm256_extractf128_ps(biased, 1)), 23), 1);
+#endif
+    r.v = _mm256_mul_ps(v, _mm256_castsi256_ps(bits));
+#else
+    float scale;
+    uint32_t bits;
+    for(int i = 0; i < Lanes; i++)
+    {
+        scale = k.v[i] + 8388735.0f;
+        memcpy(&bits, &scale, sizeof(bits));
+        bits <<= 23;
+        memcpy(&scale, &bits, sizeof(scale));
+        r.v[i] = v[i] * scale;
+    }
+#endif
+    return r;
+}
+
+/**
+ * @brief Splits positive normal values into mantissa * 2^exponent, the result is undefined for others
+ *
+ * @param mantissa (SimdFloat) Receives the mantissas in [1, 2)
+ * @return         (SimdFloat) Exponents
+ */
+inline SimdFloat SimdFloat::Exponent(SimdFloat& mantissa) const
+{
+    SimdFloat e;
+#if defined(__AVX512F__)
+    e.v = _mm512_getexp_ps(v);
+    mantissa.v = _mm512_getmant_ps(v, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero);
+#elif defined(__AVX__)
+    const __m256 fraction = _mm256_castsi256_ps(_mm256_set1_epi32(0x007FFFFF));
+#if defined(__AVX2__)
+    __m256i bits = _mm256_srli_epi32(_mm256_castps_si256(v), 23);
+#else
+    __m256i bits = _mm256_castsi128_si256(_mm_srli_epi32(_mm_castps_si128(_mm256_castps256_ps128(v)), 23));
+    bits = _mm256_insertf128_si256(bits, _mm_srli_epi32(_mm_castps_si128(_mm256_extractf128_ps(v, 1)), 23), 1);
+#endif
+    // 2^23 + biased exponent, minus 2^23 + 127
+    e.v = _mm256_or_ps(_mm256_castsi256_ps(bits), _mm256_set1_ps(8388608.0f));
+    e.v = _mm256_sub_ps(e.v, _mm256_set1_ps(8388735.0f));
+    mantissa.v = _mm256_or_ps(_mm256_and_ps(v, fraction), _mm256_set1_ps(1.0f));
+#else
+    uint32_t bits, exponent;
+    for(int i = 0; i < Lanes; i++)
+    {
+        memcpy(&bits, &v[i], sizeof(bits));
+        exponent = 0x4B000000U | (bits >> 23);
+        memcpy(&e.v[i], &exponent, sizeof(exponent));
+        e.v[i] -= 8388735.0f;
+        bits = (bits & 0x007FFFFFU) | 0x3F800000U;
+        memcpy(&mantissa.v[i], &bits, sizeof(bits));
+    }
+#endif
+    return e;
+}
+
+inline SimdFloat operator+(const SimdFloat& a, const SimdFloat& b)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_add_ps(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_add_ps(a.v, b.v);
+#else
+    for(int i = 0; i < SimdFloat::Lanes; i++) r.v[i] = a.v[i] + b.v[i];
+#endif
+    return r;
+}
+
+inline SimdFloat operator-(const SimdFloat& a, const SimdFloat& b)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_sub_ps(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_sub_ps(a.v, b.v);
+#else
+    for(int i = 0; i < SimdFloat::Lanes; i++) r.v[i] = a.v[i] - b.v[i];
+#endif
+    return r;
+}
+
+inline SimdFloat operator*(const SimdFloat& a, const SimdFloat& b)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_mul_ps(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_mul_ps(a.v, b.v);
+#else
+    for(int i = 0; i < SimdFloat::Lanes; i++) r.v[i] = a.v[i] * b.v[i];
+#endif
+    return r;
+}
+
+inline SimdFloat operator/(const SimdFloat& a, const SimdFloat& b)
+{
+    SimdFloat r;
+#if defined(__AVX512F__)
+    r.v = _mm512_div_ps(a.v, b.v);
+#elif defined(__AVX__)
+    r.v = _mm256_div_ps(a.v, b.v);
+#else
+    for(int i = 0; i < SimdFloat::Lanes; i++) r.v[i] = a.v[i] / b.v[i];
+#endif
+    return r;
+}
+
+inline SimdFloat operator+(const SimdFloat& a, float b)
+{
+    return a + SimdFloat::Broadcast(b);
+}
+
+inline SimdFloat operator-(const SimdFloat& a, float b)
+{
+    return a - SimdFloat::Broadcast(b);
+}
+
+inline SimdFloat operator*(float a, const SimdFloat& b)
+{
+    return SimdFloat::Broadcast(a) * b;
+}
+
+inline SimdFloat operator*(const SimdFloat& a, float b)
+{
+    return a * SimdFloat::Broadcast(b);
+}
+
+/**
+ * @brief Pack type of the kernels templated on the sample type
+ *        SimdPack<double>::Type is SimdDouble, SimdPack<float>::Type is SimdFloat
+ */
+template<typename T> struct SimdPack;
+
+template<> struct SimdPack<double>
+{
+    using Type = SimdDouble;
+};
+
+template<> struct SimdPack<float>
+{
+    using Type = SimdFloat;
+};
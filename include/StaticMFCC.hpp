@@ -0,0 +1,378 @@
+#pragma once
+
+#include <math.h>
+
+#include "MFCC.hpp"
+#include "MFCCEngine.hpp"
+
+/**
+ * @brief sin, cos, exp and log usable in constant expressions, for the tables of StaticMFCC
+ *        Cody-Waite reduction and Taylor series, within a few ulp of libm.
+ *
+ */
+class StaticMath
+{
+private:
+    // pi/2 and ln2 in two parts, the first ones are exact when multiplied by small integers
+    static constexpr double HalfPiHi = 1.57079632673412561417e+00;
+    static constexpr double HalfPiLo = 6.07710050650619224932e-11;
+    static constexpr double Ln2Hi = 6.93147180369123816490e-01;
+    static constexpr double Ln2Lo = 1.90821492927058770002e-10;
+    static constexpr double Sqrt2 = 1.41421356237309504880;
+
+    static constexpr double sinCos(double x, int shift);
+
+public:
+    static constexpr double Ln10 = 2.30258509299404568402;
+
+    static constexpr double Round(double x);
+    static constexpr double Sin(double x);
+    static constexpr double Cos(double x);
+    static constexpr double Exp(double x);
+    static constexpr double Log(double x);
+};
+
+/**
+ * @brief Nearest integer, halves away from zero
+ *
+ * @param x (double)
+ * @return  (double)
+ */
+constexpr double StaticMath::Round(double x)
+{
+    return (double)(long long)(x + (x >= 0 ? 0.5 : -0.5));
+}
+
+/**
+ * @brief cos(x - shift*pi/2) = cos(q*pi/2 + r), |r| <= pi/4, by the quadrant q-shift
+ *
+ * @param x     (double)
+ * @param shift (int)    0 for cos, 1 for sin
+ * @return      (double)
+ */
+constexpr double StaticMath::sinCos(double x, int shift)
+{
+    double q = Round(x / (HalfPiHi + HalfPiLo));
+    double r = (x - q * HalfPiHi) - q * HalfPiLo;
+    double r2 = r * r, sine = r, cosine = 1, term = r;
+    int quadrant = (int)(((long long)q - shift) % 4 + 4) % 4;
+
+    for(int n = 3; n <= 23; n += 2)
+    {
+        term *= -r2 / ((n - 1) * n);
+        sine += term;
+    }
+    term = 1;
+    for(int n = 2; n <= 24; n += 2)
+    {
+        term *= -r2 / ((n - 1) * n);
+        cosine += term;
+    }
+
+    switch(quadrant)
+    {
+        case 0 : return cosine;
+        case 1 : return -sine;
+        case 2 : return -cosine;
+        default: return sine;
+    }
+}
+
+constexpr double StaticMath::Sin(double x)
+{
+    return sinCos(x, 1);
+}
+
+constexpr double StaticMath::Cos(double x)
+{
+    return sinCos(x, 0);
+}
+
+/**
+ * @brief exp(x) = 2^k * exp(r), |r| <= ln2/2
+ *
+ * @param x (double)
+ * @return  (double)
+ */
+constexpr double StaticMath::Exp(double x)
+{
+    double k = Round(x / (Ln2Hi + Ln2Lo));
+    double r = (x - k * Ln2Hi) - k * Ln2Lo;
+    double sum = 1, term = 1;
+
+    for(int n = 1; n <= 25; n++)
+    {
+        term *= r / n;
+        sum += term;
+    }
+    for(; k > 0; k--) sum *= 2;
+    for(; k < 0; k++) sum /= 2;
+
+    return sum;
+}
+
+/**
+ * @brief log(x) = e*ln2 + 2*atanh(s), x = 2^e * m, m in [sqrt(1/2), sqrt(2)), s = (m-1)/(m+1)
+ *
+ * @param x (double) > 0
+ * @return  (double)
+ */
+constexpr double StaticMath::Log(double x)
+{
+    double m = x, e = 0, s = 0, s2 = 0, term = 0, sum = 0;
+
+    while(m >= Sqrt2)
+    {
+        m /= 2;
+        e++;
+    }
+    while(m < Sqrt2 / 2)
+    {
+        m *= 2;
+        e--;
+    }
+
+    s = (m - 1) / (m + 1);
+    s2 = s * s;
+    term = s;
+    sum = s;
+    for(int n = 3; n <= 41; n += 2)
+    {
+        term *= s2;
+        sum += term / n;
+    }
+
+    return e * Ln2Hi + (2 * sum + e * Ln2Lo);
+}
+
+/**
+ * @brief Tables of a fixed MFCC configuration, built by the compiler
+ *        Same formulas as the setters of BasicMFCC: window, sparse mel filterbank up to Rate/4
+ *        with the filter areas of the VAD, DCT with the lifter applied (Filters x Dims).
+ *        The FFT size is chosen like AutoSelect.
+ *
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+struct StaticMFCCData
+{
+    static constexpr int FrameSize = Rate * FrameMs / 1000;
+    static constexpr int FrameShift = Rate * ShiftMs / 1000;
+    static constexpr int MixedSize = FrameSize + FrameSize % 2;
+    static constexpr int FFTSize = FFT::EstimateCost(MixedSize) <= FFT::EstimateCost(FFT::NextPowerOfTwo(FrameSize)) ? MixedSize : FFT::NextPowerOfTwo(FrameSize);
+    static constexpr int BinCount = FFTSize / 2 + 1;
+
+    static constexpr double PI = 3.14159265358979323846;
+    static constexpr double PI2 = 2 * PI;
+    static constexpr double PI4 = 4 * PI;
+
+    static constexpr double mel2freq(double mel);
+    static constexpr double filterWeight(int filter, int bin);
+    static constexpr int weightCount();
+
+    static constexpr int WeightCount = weightCount();
+
+    double window[FrameSize];
+    int filterStart[Filters];
+    int filterLength[Filters];
+    int filterOffset[Filters];
+    double weights[WeightCount > 0 ? WeightCount : 1];
+    double filterNorm[Filters];
+    double meanLogArea;
+    T dct[Filters * Dims];
+
+    constexpr StaticMFCCData();
+};
+
+/**
+ * @brief (10^(mel/1125) - 1) * 700
+ *
+ * @param mel (double)
+ * @return    (double) Hz
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+constexpr double StaticMFCCData<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>::mel2freq(double mel)
+{
+    return (StaticMath::Exp(mel / 1125 * StaticMath::Ln10) - 1) * 700;
+}
+
+/**
+ * @brief Weight of a bin in a triangular filter, BasicMFCC::setFilterBank
+ *
+ * @param filter (int)
+ * @param bin    (int)
+ * @return       (double)
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+constexpr double StaticMFCCData<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>::filterWeight(int filter, int bin)
+{
+    double maxMel = 1125 * StaticMath::Log(1 + (Rate / 4) / 700.0) / StaticMath::Ln10;
+    double deltaMel = maxMel / (Filters + 1);
+    double lowFreq = mel2freq(deltaMel * filter);
+    double mediumFreq = mel2freq(deltaMel * (filter + 1));
+    double highFreq = mel2freq(deltaMel * (filter + 2));
+    double currentFreq = (bin * 1.0 / (BinCount - 1) * (Rate / 4));
+
+    if((currentFreq >= lowFreq) && (currentFreq <= mediumFreq))
+        return 2 * (currentFreq - lowFreq) / (mediumFreq - lowFreq);
+    if((currentFreq >= mediumFreq) && (currentFreq <= highFreq))
+        return 2 * (highFreq - currentFreq) / (highFreq - mediumFreq);
+    return 0;
+}
+
+/**
+ * @brief Number of non-zero weights of all filters, from the first to the last non-zero bin of each
+ *
+ * @return (int)
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+constexpr int StaticMFCCData<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>::weightCount()
+{
+    int count = 0, first = 0, last = 0;
+
+    for(int i = 0; i < Filters; i++)
+    {
+        first = 0;
+        while(first < BinCount && filterWeight(i, first) == 0) first++;
+        last = BinCount - 1;
+        while(last >= first && filterWeight(i, last) == 0) last--;
+        count += last - first + 1;
+    }
+    return count;
+}
+
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+constexpr StaticMFCCData<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>::StaticMFCCData() : window(), filterStart(), filterLength(), filterOffset(), weights(), filterNorm(), meanLogArea(0), dct()
+{
+    double lifter[Dims] = {}, area = 0;
+    int offset = 0, first = 0, last = 0;
+
+    ///*** Window
+    for(int i = 0; i < FrameSize; i++)
+    {
+        switch(Window)
+        {
+            case MFCC::Hamming : window[i] = 0.54 - 0.46 * StaticMath::Cos(PI2 * (double)i / FrameSize); break;
+            case MFCC::Hann : window[i] = 0.5 - 0.5 * StaticMath::Cos(PI2 * (double)i / (FrameSize - 1)); break;
+            case MFCC::Blackman : window[i] = 0.42 - 0.5 * StaticMath::Cos(PI2 * (double(i) / (FrameSize - 1))) + 0.08 * StaticMath::Cos(PI4 * (double(i) / (FrameSize - 1))); break;
+            default : window[i] = 1; break;
+        }
+    }
+
+    ///*** Filterbank, the non-zero span of every filter
+    for(int i = 0; i < Filters; i++)
+    {
+        first = 0;
+        while(first < BinCount && filterWeight(i, first) == 0) first++;
+        last = BinCount - 1;
+        while(last >= first && filterWeight(i, last) == 0) last--;
+
+        filterStart[i] = first < BinCount ? first : 0;
+        filterLength[i] = last - first + 1 > 0 ? last - first + 1 : 0;
+        filterOffset[i] = offset;
+        area = 0;
+        for(int j = first; j <= last; j++)
+        {
+            weights[offset++] = filterWeight(i, j);
+            area += filterWeight(i, j);
+        }
+
+        // Area of the filter, the VAD compares band power densities
+        area = area > 0 ? area : 1;
+        filterNorm[i] = 1.0 / area;
+        meanLogArea += StaticMath::Log(area) / Filters;
+    }
+
+    ///*** DCT and lifter
+    for(int i = 0; i < Dims; i++)
+        lifter[i] = (1.0 + 0.5 * Dims * StaticMath::Sin(PI * (i + 1) / (Dims))) / ((double)1.0 + 0.5 * Dims);
+    for(int i = 0; i < Dims; i++)
+        for(int j = 0; j < Filters; j++)
+            dct[j * Dims + i] = 2 * StaticMath::Cos((PI * (i + 1) * (2 * j + 1)) / (2 * Filters)) * lifter[i];
+}
+
+/**
+ * @brief Tables of BasicStaticMFCC for BasicMFCCEngine, all members are constants of the program
+ *
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+struct StaticMFCCTables
+{
+    typedef StaticMFCCData<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T> Data;
+
+    static constexpr Data data = Data();
+
+    static constexpr int frameSize = Data::FrameSize;
+    static constexpr int frameShift = Data::FrameShift;
+    static constexpr int fftSize = Data::FFTSize;
+    static constexpr int binCount = Data::BinCount;
+    static constexpr int filters = Filters;
+    static constexpr int dims = Dims;
+
+    static constexpr const double* window = data.window;
+    static constexpr const int* filterStart = data.filterStart;
+    static constexpr const int* filterLength = data.filterLength;
+    static constexpr const int* filterOffset = data.filterOffset;
+    static constexpr const double* weights = data.weights;
+    static constexpr const double* filterNorm = data.filterNorm;
+    static constexpr double meanLogArea = data.meanLogArea;
+    static constexpr const T* dct = data.dct;
+};
+
+/**
+ * @brief MFCC front end for one configuration fixed at compile time, the features are T
+ *        The analysis is the one of BasicMFCC (BasicMFCCEngine), only the tables differ: they are
+ *        constants of the program and every loop over the frame, the filters and the coefficients
+ *        has a constant trip count. All instances share one FFT plan.
+ *        Same features as BasicMFCC with the same settings (AutoSelect FFT) within a few 1e-13,
+ *        deltas and VAD included. The feature cache and other input rates stay with BasicMFCC.
+ *        e.g. StaticMFCC<16000, 25, 10, 40, 12, MFCC::Hamming> for MFCC(16000, 25, 10, MFCC::Hamming, 40, 12)
+ *
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T = double>
+class BasicStaticMFCC : public BasicMFCCEngine<T, StaticMFCCTables<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>>
+{
+public:
+    typedef StaticMFCCTables<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T> Tables;
+
+    static constexpr int FrameSize = Tables::frameSize;
+    static constexpr int FrameShift = Tables::frameShift;
+    static constexpr int FFTSize = Tables::fftSize;
+    static constexpr int BinCount = Tables::binCount;
+
+private:
+    /* data */
+    static const FFT& sharedPlan();
+
+public:
+    BasicStaticMFCC();
+};
+
+/**
+ * @brief Construct a new BasicStaticMFCC object, nothing is computed here
+ *
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+BasicStaticMFCC<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>::BasicStaticMFCC()
+{
+    this->m_FFT = sharedPlan();
+    this->setBuffers();
+}
+
+/**
+ * @brief Returns the FFT plan of the configuration, computed by the first instance
+ *        Every instance copies it, the transform buffers are not shared.
+ *
+ * @return (FFT)
+ */
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window, typename T>
+const FFT& BasicStaticMFCC<Rate, FrameMs, ShiftMs, Filters, Dims, Window, T>::sharedPlan()
+{
+    static const FFT plan(FFTSize);
+
+    return plan;
+}
+
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window>
+using StaticMFCC = BasicStaticMFCC<Rate, FrameMs, ShiftMs, Filters, Dims, Window, double>;
+template<int Rate, int FrameMs, int ShiftMs, int Filters, int Dims, MFCC::WindowMethod Window>
+using StaticMFCCF = BasicStaticMFCC<Rate, FrameMs, ShiftMs, Filters, Dims, Window, float>;
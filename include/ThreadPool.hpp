@@ -0,0 +1,155 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+/**
+ * @brief Fixed set of worker threads running parallel loops
+ *        Each index is passed to the task once, together with the number of the worker
+ *        running it, so workers can keep their own state (MFCC, scratch buffers, ...).
+ *        ParallelFor must not be called from inside a task.
+ *
+ */
+class ThreadPool
+{
+private:
+    /* data */
+    void workerLoop(int worker);
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_Start;
+    std::condition_variable m_Done;
+
+    //Current loop
+    const std::function<void(size_t, int)>* m_Task;
+    size_t m_TaskCount;
+    std::atomic<size_t> m_NextIndex;
+    int m_Running;
+    size_t m_Generation;
+    std::exception_ptr m_Error;
+    bool m_Stop;
+
+public:
+    ThreadPool(int threadCount = 0);
+    virtual ~ThreadPool();
+
+    void ParallelFor(size_t count, const std::function<void(size_t index, int worker)>& task);
+    int GetWorkerCount();
+};
+
+/**
+ * @brief Construct a new ThreadPool object
+ *
+ * @param threadCount (int) Number of workers, 0 for one per hardware thread
+ */
+ThreadPool::ThreadPool(int threadCount) : m_Task(nullptr), m_TaskCount(0), m_NextIndex(0), m_Running(0), m_Generation(0), m_Stop(false)
+{
+    if(threadCount <= 0)
+        threadCount = std::max(1, (int)std::thread::hardware_concurrency());
+
+    for(int i = 0; i < threadCount; i++)
+        m_Workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+/**
+ * @brief Destroy the ThreadPool object, the workers are joined
+ *
+ */
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_Start.notify_all();
+
+    for(size_t i = 0; i < m_Workers.size(); i++)
+        m_Workers[i].join();
+}
+
+/**
+ * @brief Runs task(index, worker) for index = 0..count-1 and waits until all are done
+ *        The indices are handed out one by one, so long and short tasks balance out.
+ *        The first exception thrown by a task is rethrown here.
+ *
+ * @param count (size_t)   Number of indices
+ * @param task  (function) Called with the index and the worker number (0..GetWorkerCount()-1)
+ */
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t index, int worker)>& task)
+{
+    std::exception_ptr error;
+
+    if(count == 0) return;
+
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Task = &task;
+        m_TaskCount = count;
+        m_NextIndex = 0;
+        m_Running = (int)m_Workers.size();
+        m_Error = nullptr;
+        m_Generation++;
+        m_Start.notify_all();
+
+        m_Done.wait(lock, [this] { return m_Running == 0; });
+        m_Task = nullptr;
+        error = m_Error;
+    }
+
+    if(error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief Returns the number of worker threads
+ *
+ * @return (int)
+ */
+int ThreadPool::GetWorkerCount()
+{
+    return (int)m_Workers.size();
+}
+
+/**
+ * @brief Waits for a loop, takes indices until none is left and reports back
+ *
+ * @param worker (int) Number of this worker
+ */
+void ThreadPool::workerLoop(int worker)
+{
+    size_t generation = 0;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Start.wait(lock, [this, generation] { return m_Stop || m_Generation != generation; });
+            if(m_Stop) return;
+            generation = m_Generation;
+        }
+
+        for(size_t i = m_NextIndex++; i < m_TaskCount; i = m_NextIndex++)
+        {
+            try
+            {
+                (*m_Task)(i, worker);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if(!m_Error) m_Error = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if(--m_Running == 0) m_Done.notify_one();
+        }
+    }
+}